@@ -0,0 +1,343 @@
+// Google Benchmark suite for the lidar and camera processing stages
+// Usage: PerceptionBenchmark [benchmark flags] [log file]
+//
+// Every stage runs on a synthetic arena scan and camera frame. When a log file is given,
+// the stages also run on up to MAX_RECORDED_FRAMES recorded frames, cycling through them.
+// Besides time per call, each benchmark reports heap allocations per call (allocs for operator new,
+// matAllocs for cv::Mat buffers) and frames per second.
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "utils/colorLookupTable.h"
+#include "utils/dataSaver.h"
+#include "utils/imageProcessor.h"
+#include "utils/lidarDataProcessor.h"
+#include "utils/lidarRasterizer.h"
+
+// Counts every operator new in the process so the benchmarks can report allocations per call
+static std::atomic<uint64_t> allocationCount{0};
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size ? size : 1)) return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+// cv::Mat buffers bypass operator new, cv::fastMalloc gets them from posix_memalign on Linux. Defining it here
+// interposes the libc one for OpenCV as well. With OPENCV_ENABLE_MEMALIGN=0 OpenCV uses plain malloc, which is not counted.
+static std::atomic<uint64_t> matAllocationCount{0};
+
+extern "C" int posix_memalign(void** pointer, size_t alignment, size_t size) noexcept {
+    using PosixMemalign = int (*)(void**, size_t, size_t);
+    static PosixMemalign realPosixMemalign = reinterpret_cast<PosixMemalign>(dlsym(RTLD_NEXT, "posix_memalign"));
+    matAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    return realPosixMemalign(pointer, alignment, size);
+}
+
+const int WIDTH = 1200;
+const int HEIGHT = 1200;
+const float LIDAR_SCALE = 180.0;
+
+const cv::Point CENTER(WIDTH/2, HEIGHT/2);
+
+const size_t MAX_RECORDED_FRAMES = 200;
+
+// Everything a stage needs for one frame, computed once up front so each benchmark only times its own stage
+struct Frame {
+    std::vector<lidarController::NodeData> scan;
+    cv::Mat binaryImage;
+    cv::Rect roi;  // Occupied part of binaryImage
+    std::vector<cv::Vec4i> lines;
+    std::vector<cv::Vec4i> combinedLines;
+    WallSegments walls;
+    std::vector<Direction> wallDirections;
+    WallModel wallModel;
+    cv::Mat cameraImage;
+};
+
+static void prepareFrame(Frame& frame) {
+    LidarRasterizer rasterizer(WIDTH, HEIGHT, LIDAR_SCALE);
+    frame.binaryImage = rasterizer.rasterize(frame.scan);
+    frame.roi = rasterizer.roi();
+    frame.lines = detectLines(frame.binaryImage);
+    frame.combinedLines = combineAlignedLines(frame.lines);
+    frame.walls.assign(frame.combinedLines);
+    frame.wallDirections = analyzeWallDirection(frame.walls, 0.0f, CENTER);
+    frame.wallModel = buildWallModel(frame.walls, frame.wallDirections, NORTH);
+}
+
+// Scan of a 3 x 3 m section with two traffic light pillars and some range noise
+static Frame makeSyntheticFrame() {
+    constexpr float WALL_LEFT = -1.0f;
+    constexpr float WALL_RIGHT = 2.0f;
+    constexpr float WALL_TOP = -0.5f;
+    constexpr float WALL_BOTTOM = 2.5f;
+    constexpr float PILLAR_RADIUS = 0.035f;
+    const cv::Point2f pillars[] = {{0.8f, 1.0f}, {-0.5f, 1.6f}};
+
+    Frame frame;
+    uint32_t noiseState = 12345;
+    for (int i = 0; i < 1440; ++i) {
+        float angle = i * 0.25f;
+        float theta = angle * CV_PI / 180.0f;
+        float dx = std::cos(theta);
+        float dy = std::sin(theta);
+
+        float distance = 1e9f;
+        if (dx > 0) distance = std::min(distance, WALL_RIGHT / dx);
+        if (dx < 0) distance = std::min(distance, WALL_LEFT / dx);
+        if (dy > 0) distance = std::min(distance, WALL_BOTTOM / dy);
+        if (dy < 0) distance = std::min(distance, WALL_TOP / dy);
+
+        for (const auto& pillar : pillars) {
+            float along = pillar.x * dx + pillar.y * dy;
+            float across = pillar.x * dy - pillar.y * dx;
+            if (along > 0 && std::fabs(across) < PILLAR_RADIUS) {
+                distance = std::min(distance, along - std::sqrt(PILLAR_RADIUS * PILLAR_RADIUS - across * across));
+            }
+        }
+
+        noiseState = noiseState * 1664525u + 1013904223u;
+        distance += ((noiseState >> 8) % 1000 - 500) * 0.00001f;  // +-5 mm
+        frame.scan.push_back({angle, distance});
+    }
+
+    // Camera frame with both line colors and one light of each color in the processed lower half
+    frame.cameraImage = cv::Mat(972, 1296, CV_8UC3, cv::Scalar(90, 90, 90));
+    cv::rectangle(frame.cameraImage, cv::Rect(0, 880, 600, 30), cv::Scalar(185, 69, 69), cv::FILLED);      // Blue line
+    cv::rectangle(frame.cameraImage, cv::Rect(700, 880, 596, 30), cv::Scalar(69, 124, 220), cv::FILLED);   // Orange line
+    cv::rectangle(frame.cameraImage, cv::Rect(300, 560, 80, 160), cv::Scalar(67, 71, 200), cv::FILLED);    // Red light
+    cv::rectangle(frame.cameraImage, cv::Rect(900, 600, 60, 120), cv::Scalar(110, 160, 85), cv::FILLED);   // Green light
+
+    prepareFrame(frame);
+    return frame;
+}
+
+static std::vector<Frame> loadRecordedFrames(const std::string& filePath) {
+    std::vector<Frame> frames;
+
+    DataSaver::LogReader logReader;
+    if (!logReader.open(filePath)) {
+        return frames;
+    }
+
+    DataSaver::LogEntry entry;
+    for (size_t i = 0; i < logReader.recordCount() && frames.size() < MAX_RECORDED_FRAMES; ++i) {
+        if (!logReader.readRecord(i, entry)) continue;
+
+        Frame frame;
+        frame.scan = entry.scanData;
+        // The log holds the bottom half of the frame, processImage expects the full height
+        if (!entry.image.empty()) {
+            frame.cameraImage = cv::Mat::zeros(entry.image.rows * 2, entry.image.cols, entry.image.type());
+            entry.image.copyTo(frame.cameraImage(cv::Rect(0, entry.image.rows, entry.image.cols, entry.image.rows)));
+        }
+        prepareFrame(frame);
+        frames.push_back(std::move(frame));
+    }
+
+    return frames;
+}
+
+static std::shared_ptr<ColorLookupTable> makeColorTable() {
+    auto colorTable = std::make_shared<ColorLookupTable>();
+    colorTable->build(defaultColorRanges());
+    return colorTable;
+}
+
+// Runs stage on the frames in turn and adds the allocation and frame rate counters
+template <typename Stage>
+static void runStage(benchmark::State& state, const std::vector<Frame>& frames, Stage stage) {
+    size_t index = 0;
+    uint64_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+    uint64_t matAllocationsBefore = matAllocationCount.load(std::memory_order_relaxed);
+
+    for (auto _ : state) {
+        stage(frames[index]);
+        if (++index == frames.size()) index = 0;
+    }
+
+    uint64_t allocations = allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+    uint64_t matAllocations = matAllocationCount.load(std::memory_order_relaxed) - matAllocationsBefore;
+    state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+    state.counters["matAllocs"] = benchmark::Counter(static_cast<double>(matAllocations), benchmark::Counter::kAvgIterations);
+    state.counters["fps"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+}
+
+static void registerStages(const std::string& dataset, const std::vector<Frame>* frames) {
+    auto add = [&](const std::string& name, auto stage) {
+        benchmark::RegisterBenchmark((name + "/" + dataset).c_str(), [frames, stage](benchmark::State& state) {
+            runStage(state, *frames, stage);
+        })->Unit(benchmark::kMicrosecond);
+    };
+
+    add("lidarDataToImage", [](const Frame& frame) {
+        benchmark::DoNotOptimize(lidarDataToImage(frame.scan, WIDTH, HEIGHT, LIDAR_SCALE));
+    });
+    add("LidarRasterizer", [rasterizer = std::make_shared<LidarRasterizer>(WIDTH, HEIGHT, LIDAR_SCALE)](const Frame& frame) {
+        benchmark::DoNotOptimize(rasterizer->rasterize(frame.scan));
+    });
+    add("detectLines", [](const Frame& frame) {
+        benchmark::DoNotOptimize(detectLines(frame.binaryImage));
+    });
+    add("detectLinesRoi", [](const Frame& frame) {
+        benchmark::DoNotOptimize(detectLines(frame.binaryImage, frame.roi));
+    });
+    add("detectScanLines", [](const Frame& frame) {
+        benchmark::DoNotOptimize(detectScanLines(frame.scan, WIDTH, HEIGHT, LIDAR_SCALE));
+    });
+    add("combineAlignedLines", [](const Frame& frame) {
+        benchmark::DoNotOptimize(combineAlignedLines(frame.lines));
+    });
+    add("combineAlignedLinesExhaustive", [](const Frame& frame) {
+        benchmark::DoNotOptimize(combineAlignedLinesExhaustive(frame.lines));
+    });
+    add("wallSegments", [](const Frame& frame) {
+        benchmark::DoNotOptimize(WallSegments(frame.combinedLines));
+    });
+    add("analyzeWallDirection", [](const Frame& frame) {
+        benchmark::DoNotOptimize(analyzeWallDirection(frame.walls, 0.0f, CENTER));
+    });
+    add("buildWallModel", [](const Frame& frame) {
+        benchmark::DoNotOptimize(buildWallModel(frame.walls, frame.wallDirections, NORTH));
+    });
+    add("detectTrafficLight", [](const Frame& frame) {
+        benchmark::DoNotOptimize(detectTrafficLight(frame.binaryImage, frame.walls, frame.wallModel, CLOCKWISE));
+    });
+    add("detectScanPillars", [](const Frame& frame) {
+        benchmark::DoNotOptimize(detectScanPillars(frame.scan, WIDTH, HEIGHT, LIDAR_SCALE));
+    });
+    add("detectScanTrafficLight", [](const Frame& frame) {
+        benchmark::DoNotOptimize(detectScanTrafficLight(frame.scan, WIDTH, HEIGHT, LIDAR_SCALE, frame.walls, frame.wallModel, CLOCKWISE));
+    });
+    add("detectParkingZone", [](const Frame& frame) {
+        benchmark::DoNotOptimize(detectParkingZone(frame.binaryImage, frame.roi, frame.walls, frame.wallModel, CLOCKWISE));
+    });
+    add("ColorLookupTable::classify", [colorTable = makeColorTable(), labels = std::make_shared<cv::Mat>()](const Frame& frame) {
+        if (frame.cameraImage.empty()) return;
+        colorTable->classify(frame.cameraImage, *labels);
+        benchmark::DoNotOptimize(labels->data);
+    });
+    add("classifyColors", [labels = std::make_shared<cv::Mat>()](const Frame& frame) {
+        if (frame.cameraImage.empty()) return;
+        classifyColors(frame.cameraImage, *labels);
+        benchmark::DoNotOptimize(labels->data);
+    });
+    add("processImage", [](const Frame& frame) {
+        if (frame.cameraImage.empty()) return;
+        benchmark::DoNotOptimize(processImage(frame.cameraImage));
+    });
+    add("processImagePyramid/2", [](const Frame& frame) {
+        if (frame.cameraImage.empty()) return;
+        benchmark::DoNotOptimize(processImagePyramid(frame.cameraImage, 2));
+    });
+    add("processImagePyramid/4", [](const Frame& frame) {
+        if (frame.cameraImage.empty()) return;
+        benchmark::DoNotOptimize(processImagePyramid(frame.cameraImage, 4));
+    });
+    add("processImageColorTable", [colorTable = makeColorTable()](const Frame& frame) {
+        if (frame.cameraImage.empty()) return;
+        benchmark::DoNotOptimize(processImage(frame.cameraImage, *colorTable));
+    });
+
+    // The lidar half of ObstacleChallenge::update, end to end
+    add("lidarPipeline", [rasterizer = std::make_shared<LidarRasterizer>(WIDTH, HEIGHT, LIDAR_SCALE)](const Frame& frame) {
+        const cv::Mat& binaryImage = rasterizer->rasterize(frame.scan);
+        WallSegments walls(combineAlignedLines(detectScanLines(frame.scan, WIDTH, HEIGHT, LIDAR_SCALE)));
+        auto wallDirections = analyzeWallDirection(walls, 0.0f, CENTER);
+        WallModel wallModel = buildWallModel(walls, wallDirections, NORTH);
+        benchmark::DoNotOptimize(detectScanTrafficLight(frame.scan, WIDTH, HEIGHT, LIDAR_SCALE, walls, wallModel, CLOCKWISE));
+        benchmark::DoNotOptimize(binaryImage);
+    });
+}
+
+// Hough-like output of a noisy scan: short pieces of the four walls with small angle and offset errors,
+// plus some clutter segments that merge with nothing
+static std::vector<cv::Vec4i> makeNoisySegments(size_t count) {
+    std::vector<cv::Vec4i> segments;
+    uint32_t noiseState = 54321;
+    auto next = [&](int range) {
+        noiseState = noiseState * 1664525u + 1013904223u;
+        return static_cast<int>((noiseState >> 8) % range);
+    };
+
+    while (segments.size() < count) {
+        int along = 100 + next(900);
+        int length = 10 + next(80);
+        int offset = next(9) - 4;
+        int tilt = next(7) - 3;
+        switch (next(5)) {
+            case 0: segments.push_back(cv::Vec4i(along, 150 + offset, along + length, 150 + offset + tilt)); break;
+            case 1: segments.push_back(cv::Vec4i(along, 1050 + offset, along + length, 1050 + offset + tilt)); break;
+            case 2: segments.push_back(cv::Vec4i(150 + offset, along, 150 + offset + tilt, along + length)); break;
+            case 3: segments.push_back(cv::Vec4i(1050 + offset, along, 1050 + offset + tilt, along + length)); break;
+            default: {
+                int x = next(1200), y = next(1200);
+                segments.push_back(cv::Vec4i(x, y, x + next(40) - 20, y + next(40) - 20));
+            }
+        }
+    }
+    return segments;
+}
+
+// Time of both line mergers as the number of input segments grows
+static void registerMergeScaling() {
+    auto add = [](const std::string& name, auto merge) {
+        benchmark::RegisterBenchmark(name.c_str(), [merge](benchmark::State& state) {
+            auto segments = makeNoisySegments(state.range(0));
+            for (auto _ : state) {
+                benchmark::DoNotOptimize(merge(segments));
+            }
+            state.SetComplexityN(state.range(0));
+        })->RangeMultiplier(2)->Range(64, 4096)->Complexity()->Unit(benchmark::kMicrosecond);
+    };
+
+    add("mergeScaling/combineAlignedLines", [](const std::vector<cv::Vec4i>& segments) {
+        return combineAlignedLines(segments);
+    });
+    add("mergeScaling/combineAlignedLinesExhaustive", [](const std::vector<cv::Vec4i>& segments) {
+        return combineAlignedLinesExhaustive(segments);
+    });
+}
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+
+    static std::vector<Frame> syntheticFrames = {makeSyntheticFrame()};
+    registerStages("synthetic", &syntheticFrames);
+    registerMergeScaling();
+
+    // Arguments left after benchmark::Initialize are ours
+    static std::vector<Frame> recordedFrames;
+    if (argc > 1) {
+        recordedFrames = loadRecordedFrames(argv[1]);
+        if (recordedFrames.empty()) {
+            std::cerr << "No frames loaded from " << argv[1] << ", running synthetic data only." << std::endl;
+        } else {
+            registerStages("recorded", &recordedFrames);
+        }
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -2,28 +2,64 @@
 
 #include <algorithm>
 
-// Find the longest line in a given group of walls
-cv::Vec4i findLongestLine(const std::vector<cv::Vec4i>& lines) {
-    cv::Vec4i longestLine;
+#include "../utils/trace.h"
+
+// Find the longest line in a given group of walls, returns its index in walls
+int findLongestLine(const WallSegments& walls, const std::vector<size_t>& indices) {
+    int longestLine = indices.empty() ? -1 : indices[0];
     float maxLength = 0.0f;
 
-    for (const auto& line : lines) {
-        float length = lineLength(line);
+    for (size_t index : indices) {
+        float length = walls.length[index];
         if (length > maxLength) {
             maxLength = length;
-            longestLine = line;
+            longestLine = index;
         }
     }
     return longestLine;
 }
 
-ObstacleChallenge::ObstacleChallenge(int lidarScale, cv::Point lidarCenter)
-    : lidarScale(lidarScale), lidarCenter(lidarCenter) {
+ObstacleChallenge::ObstacleChallenge(int lidarScale, cv::Point lidarCenter, std::function<float()> clock)
+    : lidarScale(lidarScale), lidarCenter(lidarCenter), clock(std::move(clock)) {
+    if (!this->clock) {
+        this->clock = [] { return static_cast<float>(cv::getTickCount()) / cv::getTickFrequency(); };
+    }
+    lastUpdateTime = this->clock();
+}
+
+void ObstacleChallenge::update(const std::vector<lidarController::NodeData>& lidarScanData, const cv::Mat& lidarBinaryImage, const cv::Mat& cameraImage, float gyroYaw, float& motorPercent, float& steeringPercent) {
+    update(lidarScanData, lidarBinaryImage, cv::Rect(0, 0, lidarBinaryImage.cols, lidarBinaryImage.rows), cameraImage, gyroYaw, motorPercent, steeringPercent);
+}
+
+void ObstacleChallenge::update(const std::vector<lidarController::NodeData>& lidarScanData, const cv::Mat& lidarBinaryImage, const cv::Rect& lidarRoi, const cv::Mat& cameraImage, float gyroYaw, float& motorPercent, float& steeringPercent) {
+    TRACE_SCOPE("ObstacleChallenge::update");
+    // Same stages as the pipeline, run one after the other
+    LidarPerception lidar;
+    lidar.scan = lidarScanData;
+    lidar.binaryImage = lidarBinaryImage;
+    lidar.roi = lidarRoi;
+    perceiveLidar(lidar);
+
+    CameraPerception camera;
+    perceiveCamera(cameraImage, camera);
+
+    update(lidar, camera, gyroYaw, motorPercent, steeringPercent);
+}
+
+void ObstacleChallenge::perceiveLidar(LidarPerception& lidar) const {
+    TRACE_SCOPE("ObstacleChallenge::perceiveLidar");
+    lidar.walls.assign(combineAlignedLines(detectScanLines(lidar.scan, lidar.binaryImage.cols, lidar.binaryImage.rows, lidarScale)));
+}
+
+void ObstacleChallenge::perceiveCamera(const cv::Mat& cameraImage, CameraPerception& camera) const {
+    TRACE_SCOPE("ObstacleChallenge::perceiveCamera");
+    camera.result = colorTable.empty() ? processImage(cameraImage) : processImage(cameraImage, colorTable);
+    camera.imageWidth = cameraImage.cols;
 }
 
-float lastUpdateTime = static_cast<float>(cv::getTickCount() / cv::getTickFrequency());
-void ObstacleChallenge::update(const cv::Mat& lidarBinaryImage, const cv::Mat& cameraImage, float gyroYaw, float& motorPercent, float& steeringPercent) {
-    float currentTime = static_cast<float>(cv::getTickCount()) / cv::getTickFrequency();
+void ObstacleChallenge::update(const LidarPerception& lidar, const CameraPerception& camera, float gyroYaw, float& motorPercent, float& steeringPercent) {
+    TRACE_SCOPE("ObstacleChallenge::control");
+    float currentTime = clock();
     float deltaTime = currentTime - lastUpdateTime;
 
     /*
@@ -31,18 +67,22 @@ void ObstacleChallenge::update(const cv::Mat& lidarBinaryImage, const cv::Mat& c
     - PARKING
     */
 
+    const auto& lidarScanData = lidar.scan;
+    const cv::Mat& lidarBinaryImage = lidar.binaryImage;
+    const cv::Rect& lidarRoi = lidar.roi;
+    const WallSegments& walls = lidar.walls;
+
     // Analyze wall directions using lidar data and relative yaw
-    auto lines = detectLines(lidarBinaryImage);
-    auto combinedLines = combineAlignedLines(lines);
-    auto wallDirections = analyzeWallDirection(combinedLines, gyroYaw, lidarCenter);
-    auto trafficLightPoints = detectTrafficLight(lidarBinaryImage, combinedLines, wallDirections, turnDirection, robotDirection);
+    auto wallDirections = analyzeWallDirection(walls, gyroYaw, lidarCenter);
+    WallModel wallModel = buildWallModel(walls, wallDirections, robotDirection);
+    auto trafficLightPoints = detectScanTrafficLight(lidarScanData, lidarBinaryImage.cols, lidarBinaryImage.rows, lidarScale, walls, wallModel, turnDirection);
 
-    auto cameraImageData = processImage(cameraImage);
+    const ImageProcessingResult& cameraImageData = camera.result;
 
     std::vector<BlockInfo> blockAngles;
     for (Block block : cameraImageData.blocks) {
         BlockInfo blockAngle;
-        blockAngle.angle = pixelToAngle(block.x, cameraImage.cols, 20, 88.0f);
+        blockAngle.angle = pixelToAngle(block.x, camera.imageWidth, 20, 88.0f);
         blockAngle.size = block.size;
         blockAngle.color = block.color;
         blockAngles.push_back(blockAngle);
@@ -50,52 +90,32 @@ void ObstacleChallenge::update(const cv::Mat& lidarBinaryImage, const cv::Mat& c
     auto processedTrafficLights = processTrafficLight(trafficLightPoints, blockAngles, lidarCenter);
 
     if (turnDirection == TurnDirection::UNKNOWN) {
-        turnDirection = lidarDetectTurnDirection(combinedLines, wallDirections, robotDirection);
-    }
-
-    std::vector<cv::Vec4i> frontWalls;
-    std::vector<cv::Vec4i> leftWalls;
-    std::vector<cv::Vec4i> rightWalls;
-
-    for (size_t i = 0; i < combinedLines.size(); ++i) {
-        cv::Vec4i line = combinedLines[i];
-        Direction direction = wallDirections[i];  // Get the direction of the current line
-
-        // TODO: Fix when the left/right wall is far (it's not inner wall)
-        if (direction == robotDirection) {
-            frontWalls.push_back(line);
-            continue;
-        } else if (direction == calculateRelativeDirection(robotDirection, RIGHT)) {
-            rightWalls.push_back(line);
-            continue;
-        } else if (direction == calculateRelativeDirection(robotDirection, LEFT)) {
-            leftWalls.push_back(line);
-            continue;
-        }
+        turnDirection = lidarDetectTurnDirection(walls, wallModel);
     }
 
+    // TODO: Fix when the left/right wall is far (it's not inner wall)
     // Select the longest wall to ensure it's the correct one
-    cv::Vec4i frontWall;
-    cv::Vec4i rightWall;
-    cv::Vec4i leftWall;
+    int frontWall = -1;
+    int rightWall = -1;
+    int leftWall = -1;
 
     float frontWallDistance = NAN;
     float leftWallDistance = NAN;
     float rightWallDistance = NAN;
 
-    if (!frontWalls.empty()) {
-        frontWall = findLongestLine(frontWalls);
-        frontWallDistance = toMeter(lidarScale, pointLinePerpendicularDistance(lidarCenter, frontWall));
+    if (!wallModel.frontWalls.empty()) {
+        frontWall = findLongestLine(walls, wallModel.frontWalls);
+        frontWallDistance = toMeter(lidarScale, walls.distance(frontWall, lidarCenter));
     }
 
-    if (!rightWalls.empty()) {
-        rightWall = findLongestLine(rightWalls);
-        rightWallDistance = toMeter(lidarScale, pointLinePerpendicularDistance(lidarCenter, rightWall));
+    if (!wallModel.rightWalls.empty()) {
+        rightWall = findLongestLine(walls, wallModel.rightWalls);
+        rightWallDistance = toMeter(lidarScale, walls.distance(rightWall, lidarCenter));
     }
 
-    if (!leftWalls.empty()) {
-        leftWall = findLongestLine(leftWalls);
-        leftWallDistance = toMeter(lidarScale, pointLinePerpendicularDistance(lidarCenter, leftWall));
+    if (!wallModel.leftWalls.empty()) {
+        leftWall = findLongestLine(walls, wallModel.leftWalls);
+        leftWallDistance = toMeter(lidarScale, walls.distance(leftWall, lidarCenter));
     }
 
     if (!isnan(frontWallDistance)) {
@@ -105,8 +125,8 @@ void ObstacleChallenge::update(const cv::Mat& lidarBinaryImage, const cv::Mat& c
                     if (not (processedTrafficLight.color == Color::RED or processedTrafficLight.color == Color::GREEN)) continue;
                     // if (processedTrafficLight.size < 600) continue;
 
-                    float trafficLightDistanceFromLeft = toMeter(lidarScale, pointLinePerpendicularDistance(processedTrafficLight.point, leftWall));
-                    float trafficLightDistanceFromFront = toMeter(lidarScale, pointLinePerpendicularDistance(processedTrafficLight.point, frontWall));
+                    float trafficLightDistanceFromLeft = toMeter(lidarScale, walls.distance(leftWall, processedTrafficLight.point));
+                    float trafficLightDistanceFromFront = toMeter(lidarScale, walls.distance(frontWall, processedTrafficLight.point));
 
                     TrafficLightPosition trafficLightPosition;
                     TrafficLightRingPosition trafficLightRingPosition;
@@ -193,8 +213,8 @@ void ObstacleChallenge::update(const cv::Mat& lidarBinaryImage, const cv::Mat& c
                     if (not (processedTrafficLight.color == Color::RED or processedTrafficLight.color == Color::GREEN)) continue;
                     // if (processedTrafficLight.size < 600) continue;
 
-                    float trafficLightDistanceFromRight = toMeter(lidarScale, pointLinePerpendicularDistance(processedTrafficLight.point, rightWall));
-                    float trafficLightDistanceFromFront = toMeter(lidarScale, pointLinePerpendicularDistance(processedTrafficLight.point, frontWall));
+                    float trafficLightDistanceFromRight = toMeter(lidarScale, walls.distance(rightWall, processedTrafficLight.point));
+                    float trafficLightDistanceFromFront = toMeter(lidarScale, walls.distance(frontWall, processedTrafficLight.point));
 
                     TrafficLightPosition trafficLightPosition;
                     TrafficLightRingPosition trafficLightRingPosition;
@@ -640,7 +660,7 @@ void ObstacleChallenge::update(const cv::Mat& lidarBinaryImage, const cv::Mat& c
         case State::FIND_PARKING_ZONE:
             motorPercent = 0.25f;
 
-            auto potentialParkingWalls = detectParkingZone(lidarBinaryImage, combinedLines, wallDirections, turnDirection, robotDirection);
+            auto potentialParkingWalls = detectParkingZone(lidarBinaryImage, lidarRoi, walls, wallModel, turnDirection);
 
             std::vector<cv::Vec4i> parkingWalls;
             for (const auto& potentialParkingWall : potentialParkingWalls) {
@@ -719,7 +739,7 @@ void ObstacleChallenge::update(const cv::Mat& lidarBinaryImage, const cv::Mat& c
         case State::PARKING_1:
             motorPercent = 0.18;
 
-            auto potentialParkingWalls = detectParkingZone(lidarBinaryImage, combinedLines, wallDirections, turnDirection, robotDirection);
+            auto potentialParkingWalls = detectParkingZone(lidarBinaryImage, lidarRoi, walls, wallModel, turnDirection);
 
             std::vector<cv::Vec4i> parkingWalls;
             for (const auto& potentialParkingWall : potentialParkingWalls) {
@@ -3,9 +3,11 @@
 
 #include <queue>
 #include <unordered_set>
+#include <functional>
 #include <vector>
 #include <opencv2/opencv.hpp>
 
+#include "../utils/colorLookupTable.h"
 #include "../utils/imageProcessor.h"
 #include "../utils/lidarDataProcessor.h"
 #include "../utils/PIDController.cpp"
@@ -63,6 +65,28 @@ namespace std {
     };
 }
 
+/**
+ * @brief Lidar results that do not depend on the challenge state, produced once per scan.
+ */
+struct LidarPerception {
+    uint64_t timestampNs = 0;                       ///< trace::nowNs timeline, when the rotation finished
+    uint64_t sequence = 0;                          ///< LidarScan::sequence, 0 until the first scan
+    std::vector<lidarController::NodeData> scan;
+    cv::Mat binaryImage;                            ///< Rasterized scan, zero outside roi
+    cv::Rect roi;
+    WallSegments walls;                             ///< Filled by ObstacleChallenge::perceiveLidar
+};
+
+/**
+ * @brief Camera results that do not depend on the challenge state, produced once per frame.
+ */
+struct CameraPerception {
+    uint64_t timestampNs = 0;                       ///< trace::nowNs timeline, when the frame was received
+    uint64_t sequence = 0;                          ///< Counts frames, 0 until the first one
+    ImageProcessingResult result;
+    int imageWidth = 0;
+};
+
 class ObstacleChallenge {
 private:
     PIDController steeringPID = PIDController(0.026f, 0.0f, 0.0008f);
@@ -110,6 +134,10 @@ private:
     int lidarScale;
     cv::Point lidarCenter;          // Center point of the lidar map
 
+    std::function<float()> clock;   // Returns the current time in seconds
+    ColorLookupTable colorTable;    // Camera pixel classifier, the HSV ranges are used while it is empty
+    float lastUpdateTime;
+
     Direction robotDirection = NORTH;
     TurnDirection turnDirection = UNKNOWN;
     int numberofTurn = 0;
@@ -120,10 +148,49 @@ public:
      * 
      * @param lidarCenter Center point of the lidar map.
      * @param initialGyroYaw Initial yaw angle from the gyro.
+     * @param clock Time source in seconds, defaults to cv::getTickCount. Replays pass the logged time.
+     */
+    ObstacleChallenge(int lidarScale, cv::Point lidarCenter, std::function<float()> clock = nullptr);
+
+    /**
+     * @brief Update motor and steering percentages from the latest sensor data.
+     *
+     * @param lidarScanData Scan points from the lidar, walls are extracted from them directly.
+     * @param lidarBinaryImage Rasterized scan, still used for parking zone detection.
+     * @param lidarRoi Part of lidarBinaryImage that holds points (LidarRasterizer::roi), only this part is searched.
+     * @param cameraImage Current camera frame.
+     * @param gyroYaw Current yaw angle from the gyro.
+     * @param motorPercent Output parameter for motor speed as a percentage (-1.0 to 1.0).
+     * @param steeringPercent Output parameter for steering angle as a percentage (-1.0 to 1.0).
+     */
+    void update(const std::vector<lidarController::NodeData>& lidarScanData, const cv::Mat& lidarBinaryImage, const cv::Rect& lidarRoi, const cv::Mat& cameraImage, float gyroYaw, float& motorPercent, float& steeringPercent);
+
+    /**
+     * @brief Same as above, searching the whole lidarBinaryImage.
      */
-    ObstacleChallenge(int lidarScale, cv::Point lidarCenter);
+    void update(const std::vector<lidarController::NodeData>& lidarScanData, const cv::Mat& lidarBinaryImage, const cv::Mat& cameraImage, float gyroYaw, float& motorPercent, float& steeringPercent);
 
-    void update(const cv::Mat& lidarBinaryImage, const cv::Mat& cameraImage, float gyroYaw, float& motorPercent, float& steeringPercent);
+    /**
+     * @brief Lidar stage: extracts the walls of lidar.scan. Only reads the constructor settings,
+     * so it can run on its own thread next to update.
+     */
+    void perceiveLidar(LidarPerception& lidar) const;
+
+    /**
+     * @brief Camera stage: color segmentation of cameraImage. Thread safe like perceiveLidar,
+     * setColorLookupTable must not be called while it runs.
+     */
+    void perceiveCamera(const cv::Mat& cameraImage, CameraPerception& camera) const;
+
+    /**
+     * @brief Control step on results the stages already produced, e.g. the newest ones of a pipeline.
+     */
+    void update(const LidarPerception& lidar, const CameraPerception& camera, float gyroYaw, float& motorPercent, float& steeringPercent);
+
+    /**
+     * @brief Classify camera pixels with a precomputed table instead of converting every frame to HSV.
+     */
+    void setColorLookupTable(ColorLookupTable table) { colorTable = std::move(table); }
 };
 
 #endif // OBSTACLECHALLENGE_H
@@ -2,16 +2,18 @@
 
 #include <algorithm>
 
-// Find the longest line in a given group of walls
-cv::Vec4i findLongestLine(const std::vector<cv::Vec4i>& lines) {
-    cv::Vec4i longestLine;
+#include "../utils/trace.h"
+
+// Find the longest line in a given group of walls, returns its index in walls
+int findLongestLine(const WallSegments& walls, const std::vector<size_t>& indices) {
+    int longestLine = indices.empty() ? -1 : indices[0];
     float maxLength = 0.0f;
 
-    for (const auto& line : lines) {
-        float length = lineLength(line);
+    for (size_t index : indices) {
+        float length = walls.length[index];
         if (length > maxLength) {
             maxLength = length;
-            longestLine = line;
+            longestLine = index;
         }
     }
     return longestLine;
@@ -19,70 +21,53 @@ cv::Vec4i findLongestLine(const std::vector<cv::Vec4i>& lines) {
 
 
 
-OpenChallenge::OpenChallenge(int lidarScale, cv::Point lidarCenter) 
-    : lidarScale(lidarScale), lidarCenter(lidarCenter) {
+OpenChallenge::OpenChallenge(int lidarScale, cv::Point lidarCenter, std::function<float()> clock)
+    : lidarScale(lidarScale), lidarCenter(lidarCenter), clock(std::move(clock)) {
+    if (!this->clock) {
+        this->clock = [] { return static_cast<float>(cv::getTickCount()) / cv::getTickFrequency(); };
+    }
+    lastUpdateTime = this->clock();
     // Constructor: Initialize variables or perform setup if needed.
 }
 
-float lastUpdateTime = static_cast<float>(cv::getTickCount() / cv::getTickFrequency());
-void OpenChallenge::update(const cv::Mat& lidarBinaryImage, float gyroYaw, float& motorPercent, float& steeringPercent) {
-float currentTime = static_cast<float>(cv::getTickCount()) / cv::getTickFrequency();
+void OpenChallenge::update(const std::vector<lidarController::NodeData>& lidarScanData, float gyroYaw, float& motorPercent, float& steeringPercent) {
+    TRACE_SCOPE("OpenChallenge::update");
+float currentTime = clock();
     float deltaTime = currentTime - lastUpdateTime;
 
    // Analyze wall directions using lidar data and relative yaw
-    auto lines = detectLines(lidarBinaryImage);
-    auto combinedLines = combineAlignedLines(lines);
-    auto wallDirections = analyzeWallDirection(combinedLines, gyroYaw, lidarCenter);
-    auto trafficLightPoints = detectTrafficLight(lidarBinaryImage, combinedLines, wallDirections, turnDirection, robotDirection);
+    auto lines = detectScanLines(lidarScanData, lidarCenter.x * 2, lidarCenter.y * 2, lidarScale);
+    WallSegments walls(combineAlignedLines(lines));
+    auto wallDirections = analyzeWallDirection(walls, gyroYaw, lidarCenter);
+    WallModel wallModel = buildWallModel(walls, wallDirections, robotDirection);
 
     if (turnDirection == TurnDirection::UNKNOWN) {
-        turnDirection = lidarDetectTurnDirection(combinedLines, wallDirections, robotDirection);
-    }
-
-    std::vector<cv::Vec4i> frontWalls;
-    std::vector<cv::Vec4i> leftWalls;
-    std::vector<cv::Vec4i> rightWalls;
-    
-    for (size_t i = 0; i < combinedLines.size(); ++i) {
-        cv::Vec4i line = combinedLines[i];
-        Direction direction = wallDirections[i];  // Get the direction of the current line
-
-        // TODO: Fix when the left/right wall is far (it's not inner wall)
-        if (direction == robotDirection) {
-            frontWalls.push_back(line);
-            continue;
-        } else if (direction == calculateRelativeDirection(robotDirection, RIGHT)) {
-            rightWalls.push_back(line);
-            continue;
-        } else if (direction == calculateRelativeDirection(robotDirection, LEFT)) {
-            leftWalls.push_back(line);
-            continue;
-        }
+        turnDirection = lidarDetectTurnDirection(walls, wallModel);
     }
 
-
+    // TODO: Fix when the left/right wall is far (it's not inner wall)
     // Select the longest wall to ensure it's the correct one
-    cv::Vec4i frontWall;
-    cv::Vec4i rightWall;
-    cv::Vec4i leftWall;
+    int frontWall = -1;
+    int rightWall = -1;
+    int leftWall = -1;
 
     float frontWallDistance = NAN;
     float leftWallDistance = NAN;
     float rightWallDistance = NAN;
 
-    if (!frontWalls.empty()) {
-        frontWall = findLongestLine(frontWalls);
-        frontWallDistance = toMeter(lidarScale, pointLinePerpendicularDistance(lidarCenter, frontWall));
+    if (!wallModel.frontWalls.empty()) {
+        frontWall = findLongestLine(walls, wallModel.frontWalls);
+        frontWallDistance = toMeter(lidarScale, walls.distance(frontWall, lidarCenter));
     }
 
-    if (!rightWalls.empty()) {
-        rightWall = findLongestLine(rightWalls);
-        rightWallDistance = toMeter(lidarScale, pointLinePerpendicularDistance(lidarCenter, rightWall));
+    if (!wallModel.rightWalls.empty()) {
+        rightWall = findLongestLine(walls, wallModel.rightWalls);
+        rightWallDistance = toMeter(lidarScale, walls.distance(rightWall, lidarCenter));
     }
 
-    if (!leftWalls.empty()) {
-        leftWall = findLongestLine(leftWalls);
-        leftWallDistance = toMeter(lidarScale, pointLinePerpendicularDistance(lidarCenter, leftWall));
+    if (!wallModel.leftWalls.empty()) {
+        leftWall = findLongestLine(walls, wallModel.leftWalls);
+        leftWallDistance = toMeter(lidarScale, walls.distance(leftWall, lidarCenter));
     }
 
 
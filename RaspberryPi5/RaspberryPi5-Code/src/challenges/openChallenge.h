@@ -1,6 +1,7 @@
 #ifndef OPENCHALLENGE_H
 #define OPENCHALLENGE_H
 
+#include <functional>
 #include <vector>
 #include <opencv2/opencv.hpp>
 
@@ -40,6 +41,9 @@ private:
     int lidarScale;
     cv::Point lidarCenter;          // Center point of the lidar map
 
+    std::function<float()> clock;   // Returns the current time in seconds
+    float lastUpdateTime;
+
     Direction robotDirection = NORTH;
     TurnDirection turnDirection = UNKNOWN;
     int numberofTurn = 0;
@@ -50,18 +54,19 @@ public:
      * 
      * @param center Center point of the lidar map.
      * @param initialGyroYaw Initial yaw angle from the gyro.
+     * @param clock Time source in seconds, defaults to cv::getTickCount. Replays pass the logged time.
      */
-    OpenChallenge(int lidarScale, cv::Point lidarCenter);
+    OpenChallenge(int lidarScale, cv::Point lidarCenter, std::function<float()> clock = nullptr);
 
     /**
      * @brief Update motor and steering percentages based on detected lines and current gyro yaw.
      * 
-     * @param combined_lines Vector of detected and combined lines.
+     * @param lidarScanData Scan points from the lidar, walls are extracted from them directly.
      * @param gyroYaw Current yaw angle from the gyro.
      * @param motorPercent Output parameter for motor speed as a percentage (-1.0 to 1.0).
      * @param steeringPercent Output parameter for steering angle as a percentage (-1.0 to 1.0).
      */
-    void update(const cv::Mat& lidarBinaryImage, float gyroYaw, float& motorPercent, float& steeringPercent);
+    void update(const std::vector<lidarController::NodeData>& lidarScanData, float gyroYaw, float& motorPercent, float& steeringPercent);
 };
 
 #endif // OPENCHALLENGE_H
@@ -0,0 +1,134 @@
+// Builds the camera color lookup table from a ranges file and saves it for ObstacleChallenge
+// Usage: BuildColorTable <ranges file | --defaults> [output table] [bits per channel]
+//        BuildColorTable --print-defaults > colorRanges.txt
+//
+// A ranges file has one HSV range per line, colors may repeat (e.g. red on both ends of the hue circle):
+//   # color  h low  s low  v low  h high  s high  v high
+//   red      0      135    160    2       205     255
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "utils/colorLookupTable.h"
+#include "utils/imageProcessor.h"
+
+const char* COLOR_TABLE_PATH = "config/colorTable.bin";
+
+static const std::pair<const char*, uint8_t> colorNames[] = {
+    {"blue", LABEL_BLUE},
+    {"orange", LABEL_ORANGE},
+    {"red", LABEL_RED},
+    {"green", LABEL_GREEN},
+    {"pink", LABEL_PINK},
+};
+
+static bool loadColorRanges(const std::string& filePath, std::vector<ColorRange>& ranges) {
+    std::ifstream file(filePath);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open color ranges file: " << filePath << std::endl;
+        return false;
+    }
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); lineNumber++) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string name;
+        if (!(fields >> name)) continue;  // Blank or comment line
+
+        ColorRange range;
+        range.label = 0;
+        for (const auto& [colorName, label] : colorNames) {
+            if (name == colorName) range.label = label;
+        }
+        double values[6];
+        bool valid = range.label != 0;
+        for (double& value : values) {
+            valid = valid && (fields >> value) && value >= 0 && value <= 255;
+        }
+        if (!valid) {
+            std::cerr << filePath << ":" << lineNumber << ": expected <color> and 6 values between 0 and 255" << std::endl;
+            return false;
+        }
+        range.lower = cv::Scalar(values[0], values[1], values[2]);
+        range.upper = cv::Scalar(values[3], values[4], values[5]);
+        ranges.push_back(range);
+    }
+
+    if (ranges.empty()) {
+        std::cerr << "No color ranges in " << filePath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static void printColorRanges(const std::vector<ColorRange>& ranges) {
+    printf("# color  h low  s low  v low  h high  s high  v high\n");
+    for (const auto& range : ranges) {
+        for (const auto& [colorName, label] : colorNames) {
+            if (range.label != label) continue;
+            printf("%-8s %-6g %-6g %-6g %-7g %-7g %g\n", colorName,
+                   range.lower[0], range.lower[1], range.lower[2], range.upper[0], range.upper[1], range.upper[2]);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <ranges file | --defaults> [output table] [bits per channel]" << std::endl;
+        std::cerr << "       " << argv[0] << " --print-defaults" << std::endl;
+        return -1;
+    }
+    if (std::strcmp(argv[1], "--print-defaults") == 0) {
+        printColorRanges(defaultColorRanges());
+        return 0;
+    }
+
+    std::vector<ColorRange> ranges;
+    if (std::strcmp(argv[1], "--defaults") == 0) {
+        ranges = defaultColorRanges();
+    } else if (!loadColorRanges(argv[1], ranges)) {
+        return -1;
+    }
+    const char* outputPath = argc > 2 ? argv[2] : COLOR_TABLE_PATH;
+    int bitsPerChannel = argc > 3 ? std::atoi(argv[3]) : ColorLookupTable::DEFAULT_BITS_PER_CHANNEL;
+
+    ColorLookupTable colorTable;
+    if (!colorTable.build(ranges, bitsPerChannel)) {
+        return -1;
+    }
+
+    // Quantization error: every 24 bit color against the exact table of the same ranges
+    if (bitsPerChannel < 8) {
+        ColorLookupTable exactTable;
+        exactTable.build(ranges, 8);
+        size_t changed = 0, labeled = 0, labeledChanged = 0;
+        for (int b = 0; b < 256; b++) {
+            for (int g = 0; g < 256; g++) {
+                for (int r = 0; r < 256; r++) {
+                    uint8_t exact = exactTable.lookup(b, g, r);
+                    bool differs = colorTable.lookup(b, g, r) != exact;
+                    changed += differs;
+                    if (exact) {
+                        labeled++;
+                        labeledChanged += differs;
+                    }
+                }
+            }
+        }
+        printf("%d bits per channel: %.2f%% of all colors and %.2f%% of the colors inside a range change label\n",
+               bitsPerChannel, 100.0 * changed / (1 << 24), labeled > 0 ? 100.0 * labeledChanged / labeled : 0.0);
+    }
+
+    if (!colorTable.save(outputPath)) {
+        return -1;
+    }
+    printf("Saved %zu ranges as a %d bit color table to %s\n", ranges.size(), bitsPerChannel, outputPath);
+    return 0;
+}
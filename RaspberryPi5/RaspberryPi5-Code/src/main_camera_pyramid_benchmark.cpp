@@ -0,0 +1,147 @@
+// Compares processImagePyramid against the full resolution processImage on frames from a recorded log
+// Usage: CameraPyramidBenchmark [log file] [max frames]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "utils/dataSaver.h"
+#include "utils/imageProcessor.h"
+
+// Differences of one mode against the full resolution reference, summed over all frames
+struct Accuracy {
+    int lineMisses = 0;         // Line found by one side only
+    int lineCount = 0;
+    double lineYError = 0.0;    // px
+    double lineSizeError = 0.0; // Relative
+    int blockCountMisses = 0;   // Frames with a different number of red or green blocks
+    int blockCount = 0;
+    double blockCenterError = 0.0;  // px
+    double blockSizeError = 0.0;    // Relative
+    int pinkMisses = 0;
+    int pinkCount = 0;
+    double pinkCenterError = 0.0;   // px
+};
+
+static double relativeError(int value, int reference) {
+    return reference > 0 ? std::abs(value - reference) / static_cast<double>(reference) : 0.0;
+}
+
+static void compareLine(int y, int size, int referenceY, int referenceSize, Accuracy& accuracy) {
+    if ((y >= 0) != (referenceY >= 0)) {
+        accuracy.lineMisses++;
+    } else if (referenceY >= 0) {
+        accuracy.lineCount++;
+        accuracy.lineYError += std::abs(y - referenceY);
+        accuracy.lineSizeError += relativeError(size, referenceSize);
+    }
+}
+
+static void compare(const ImageProcessingResult& result, const ImageProcessingResult& reference, Accuracy& accuracy) {
+    compareLine(result.blueLineY, result.blueLineSize, reference.blueLineY, reference.blueLineSize, accuracy);
+    compareLine(result.orangeLineY, result.orangeLineSize, reference.orangeLineY, reference.orangeLineSize, accuracy);
+
+    if (result.blocks.size() != reference.blocks.size()) {
+        accuracy.blockCountMisses++;
+    }
+    // Each reference block against the closest block of the same color
+    for (const auto& referenceBlock : reference.blocks) {
+        const Block* closest = nullptr;
+        double closestDistance = std::numeric_limits<double>::max();
+        for (const auto& block : result.blocks) {
+            if (block.color != referenceBlock.color) continue;
+            double distance = std::hypot(block.x - referenceBlock.x, block.y - referenceBlock.y);
+            if (distance < closestDistance) {
+                closestDistance = distance;
+                closest = &block;
+            }
+        }
+        if (closest) {
+            accuracy.blockCount++;
+            accuracy.blockCenterError += closestDistance;
+            accuracy.blockSizeError += relativeError(closest->size, referenceBlock.size);
+        }
+    }
+
+    if ((result.pinkSize > 0) != (reference.pinkSize > 0)) {
+        accuracy.pinkMisses++;
+    } else if (reference.pinkSize > 0) {
+        accuracy.pinkCount++;
+        accuracy.pinkCenterError += std::hypot(result.pinkX - reference.pinkX, result.pinkY - reference.pinkY);
+    }
+}
+
+static double average(double sum, int count) {
+    return count > 0 ? sum / count : 0.0;
+}
+
+int main(int argc, char** argv) {
+    const char* logPath = argc > 1 ? argv[1] : "log/logData3.bin";
+    size_t maxFrames = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 300;
+
+    DataSaver::LogReader logReader;
+    if (!logReader.open(logPath)) {
+        return -1;
+    }
+
+    // The log holds the bottom half of the frame, processImage expects the full height
+    std::vector<cv::Mat> frames;
+    DataSaver::LogEntry entry;
+    for (size_t i = 0; i < logReader.recordCount() && frames.size() < maxFrames; ++i) {
+        if (logReader.readRecord(i, entry) && !entry.image.empty()) {
+            cv::Mat frame = cv::Mat::zeros(entry.image.rows * 2, entry.image.cols, entry.image.type());
+            entry.image.copyTo(frame(cv::Rect(0, entry.image.rows, entry.image.cols, entry.image.rows)));
+            frames.push_back(frame);
+        }
+    }
+    if (frames.empty()) {
+        std::cerr << "No camera images found in " << logPath << std::endl;
+        return -1;
+    }
+
+    printf("%zu frames of %dx%d\n\n", frames.size(), frames[0].cols, frames[0].rows);
+
+    std::vector<ImageProcessingResult> references;
+    auto referenceStart = std::chrono::steady_clock::now();
+    for (const auto& frame : frames) {
+        references.push_back(processImage(frame));
+    }
+    double referenceMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - referenceStart).count();
+
+    printf("%-10s %8s %12s %10s %10s %12s %12s %10s %10s %10s\n",
+           "mode", "ms", "line miss", "line dy", "line size", "block miss", "block dxy", "block size", "pink miss", "pink dxy");
+    printf("%-10s %8.2f\n", "full", referenceMs / frames.size());
+
+    for (int downscale : {1, 2, 4}) {
+        Accuracy accuracy;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<ImageProcessingResult> results;
+        for (const auto& frame : frames) {
+            results.push_back(processImagePyramid(frame, downscale));
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        for (size_t i = 0; i < frames.size(); ++i) {
+            compare(results[i], references[i], accuracy);
+        }
+
+        printf("1/%-8d %8.2f %12d %10.2f %9.1f%% %12d %12.2f %9.1f%% %10d %10.2f\n",
+               downscale,
+               ms / frames.size(),
+               accuracy.lineMisses,
+               average(accuracy.lineYError, accuracy.lineCount),
+               100.0 * average(accuracy.lineSizeError, accuracy.lineCount),
+               accuracy.blockCountMisses,
+               average(accuracy.blockCenterError, accuracy.blockCount),
+               100.0 * average(accuracy.blockSizeError, accuracy.blockCount),
+               accuracy.pinkMisses,
+               average(accuracy.pinkCenterError, accuracy.pinkCount));
+    }
+
+    return 0;
+}
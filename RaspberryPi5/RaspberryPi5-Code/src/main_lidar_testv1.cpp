@@ -93,6 +93,7 @@ int main(int argc, char **argv) {
     cam.options->gain = 10.0; // Increase gain for brightness compensation
     cam.options->setExposureMode(Exposure_Modes::EXPOSURE_SHORT);
     cam.options->verbose = true;
+    cam.options->transform = libcamera::Transform::Rot180; // Camera is mounted upside down
     cam.startVideo();
 
 
@@ -126,8 +127,8 @@ int main(int argc, char **argv) {
     while (not(status[0] & (1 << 1))) {
         i2c_master_read_status(fd, status);
 
-        i2c_master_read_logs(fd, logs);
-        i2c_master_print_logs(logs, sizeof(logs));
+        size_t newLogCount = i2c_master_read_new_logs(fd, logs, sizeof(logs));
+        i2c_master_print_logs(logs, newLogCount);
 
         std::this_thread::sleep_for(std::chrono::milliseconds(50));
     }
@@ -188,26 +189,27 @@ int main(int argc, char **argv) {
 
 
     int64 start = cv::getTickCount();
+    std::vector<lidarController::NodeData> lidarScanData;
+    lidarController::LidarController::reserveScanBuffer(lidarScanData);
+
     while (isRunning) {
-        cv::Mat rawCameraImage;
-        if(!cam.getVideoFrame(rawCameraImage, 1000)){
+        cv::Mat cameraImage;
+        if(!cam.getVideoFrame(cameraImage, 1000)){
             std::cout<<"Timeout error"<<std::endl;
         }
-        cv::Mat cameraImage;
-        cv::flip(rawCameraImage, cameraImage, -1);
 
 
         bno055_accel_float_t accelData;
         bno055_euler_float_t eulerData;
         i2c_master_read_bno055_accel_and_euler(fd, &accelData, &eulerData);
 
-        i2c_master_read_logs(fd, logs);
-        i2c_master_print_logs(logs, sizeof(logs));
+        size_t newLogCount = i2c_master_read_new_logs(fd, logs, sizeof(logs));
+        i2c_master_print_logs(logs, newLogCount);
 
 
 
 
-        auto lidarScanData = lidar.getScanData();
+        lidar.getScanData(lidarScanData);
         // lidar.printScanData(lidarScanData);
 
         cv::Mat binaryImage = lidarDataToImage(lidarScanData, LIDAR_WIDTH, LIDAR_HEIGHT, LIDAR_SCALE);
@@ -12,6 +12,7 @@
 #include "utils/lidarDataProcessor.h"
 #include "utils/imageProcessor.h"
 #include "utils/dataSaver.h"
+#include "utils/logMappedReader.h"
 
 const int LIDAR_WIDTH = 1200;
 const int LIDAR_HEIGHT = 1200;
@@ -66,22 +67,53 @@ void drawRadialLines(cv::Mat &image, const cv::Point &center, float angle, int l
 
 
 
-int main() {
+int main(int argc, char** argv) {
     cv::namedWindow("LIDAR Hough Lines", cv::WINDOW_AUTOSIZE);
     cv::setMouseCallback("LIDAR Hough Lines", onMouse, nullptr);
 
-    // Load all scan data from file
-    std::vector<std::vector<lidarController::NodeData>> allScanData;
-    std::vector<bno055_accel_float_t> allAccelData;
-    std::vector<bno055_euler_float_t> allEulerData;
-    std::vector<cv::Mat> allCameraImage;
-    DataSaver::loadLogData("log/logData3.bin", allScanData, allAccelData, allEulerData, allCameraImage);
+    // Only the frame index is loaded here, each frame is read when it is shown.
+    // Version 1 logs are memory-mapped, legacy logs are read through LogReader.
+    const char* logPath = argc > 1 ? argv[1] : "log/logData3.bin";
+    DataSaver::LogMappedReader mappedReader;
+    DataSaver::LogReader logReader;
+    auto mappedStatus = mappedReader.open(logPath);
+    bool useMapping = mappedStatus == DataSaver::LogMappedReader::OpenStatus::OK;
+    if (mappedStatus == DataSaver::LogMappedReader::OpenStatus::FAILED
+        || (mappedStatus == DataSaver::LogMappedReader::OpenStatus::LEGACY && !logReader.open(logPath))) {
+        std::cerr << "No scan data found in file or failed to load." << std::endl;
+        return -1;
+    }
 
-    if (allScanData.empty() || allAccelData.empty() || allEulerData.empty() || allCameraImage.empty()) {
+    size_t recordCount = useMapping ? mappedReader.recordCount() : logReader.recordCount();
+    if (recordCount == 0) {
         std::cerr << "No scan data found in file or failed to load." << std::endl;
         return -1;
     }
 
+    // Mapped scans are used in place, scanView points into the mapping or into logEntry.scanData
+    DataSaver::LogEntry logEntry;
+    DataSaver::NodeDataView scanView;
+    auto loadFrame = [&](size_t index, bool withImage) {
+        if (!useMapping) {
+            bool loaded = logReader.readRecord(index, logEntry, withImage);
+            scanView = {logEntry.scanData.data(), logEntry.scanData.size()};
+            return loaded;
+        }
+
+        DataSaver::LogRecordView record = mappedReader.record(index);
+        logEntry.timestampUs = record.timestampUs;
+        scanView = record.scanData;
+        logEntry.accel_data = record.accel_data;
+        logEntry.euler_data = record.euler_data;
+        logEntry.image = withImage ? mappedReader.image(index) : cv::Mat();
+        return true;
+    };
+
+    if (!loadFrame(0, false)) {
+        std::cerr << "Failed to read the first record." << std::endl;
+        return -1;
+    }
+
 
 
     printf("Press Any Key to Start\n");  
@@ -89,8 +121,9 @@ int main() {
 
 
 
-    bno055_accel_float_t initialAccelData = allAccelData[0];
-    bno055_euler_float_t initialEulerData = allEulerData[0];
+    bno055_accel_float_t initialAccelData = logEntry.accel_data;
+    bno055_euler_float_t initialEulerData = logEntry.euler_data;
+    size_t loadedFrameIndex = SIZE_MAX;
 
     while (true) {
         if (playVideo) {
@@ -106,12 +139,18 @@ int main() {
         if (key == 'q') break; // Exit loop
 
         // Boundary check during play
-        if (frameIndex >= allScanData.size()) frameIndex = allScanData.size() - 1;
-
-
+        if (frameIndex >= recordCount) frameIndex = recordCount - 1;
+
+        if (frameIndex != loadedFrameIndex) {
+            if (!loadFrame(frameIndex, true)) {
+                std::cerr << "Failed to read frame " << frameIndex << "." << std::endl;
+                break;
+            }
+            loadedFrameIndex = frameIndex;
+        }
 
 
-        cv::Mat rawCameraImage = allCameraImage[frameIndex];
+        cv::Mat rawCameraImage = logEntry.image;
         cv::Mat cameraImage(rawCameraImage.rows * 2, rawCameraImage.cols, rawCameraImage.type());
         cameraImage.setTo(cv::Scalar(0, 0, 0)); // black in BGR
         rawCameraImage.copyTo(cameraImage(cv::Rect(0, rawCameraImage.rows, rawCameraImage.cols, rawCameraImage.rows)));
@@ -120,13 +159,10 @@ int main() {
         // cv::Mat cameraImage;
         // cv::flip(allCameraImage[frameIndex], cameraImage, 1);
 
-        bno055_accel_float_t accelData = allAccelData[frameIndex];
-        bno055_euler_float_t eulerData = allEulerData[frameIndex];
-
-        auto lidarScanData = allScanData[frameIndex];
-
+        bno055_accel_float_t accelData = logEntry.accel_data;
+        bno055_euler_float_t eulerData = logEntry.euler_data;
 
-        cv::Mat binaryImage = lidarDataToImage(lidarScanData, LIDAR_WIDTH, LIDAR_HEIGHT, LIDAR_SCALE);
+        cv::Mat binaryImage = lidarDataToImage(scanView.data, scanView.size(), LIDAR_WIDTH, LIDAR_HEIGHT, LIDAR_SCALE);
         // cv::Mat binaryImage;
         // cv::flip(lidarDataToImage(lidarScanData, LIDAR_WIDTH, LIDAR_HEIGHT, LIDAR_SCALE), binaryImage, 1);
         cv::Mat lidarOutputImage = cv::Mat::zeros(LIDAR_HEIGHT, LIDAR_WIDTH, CV_8UC3);
@@ -0,0 +1,113 @@
+// Compares the camera image encodings of the logger on frames from a recorded log
+// Usage: LogCodecBenchmark [log file] [max frames]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+#include "utils/dataSaver.h"
+
+struct CodecCase {
+    std::string name;
+    DataSaver::LogImageOptions options;
+};
+
+static DataSaver::LogImageOptions makeOptions(DataSaver::LogImageEncoding encoding, int jpegQuality = 90, int pngCompression = 1) {
+    DataSaver::LogImageOptions options;
+    options.encoding = encoding;
+    options.jpegQuality = jpegQuality;
+    options.pngCompression = pngCompression;
+    return options;
+}
+
+int main(int argc, char** argv) {
+    const char* logPath = argc > 1 ? argv[1] : "log/logData3.bin";
+    size_t maxFrames = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 60;
+
+    DataSaver::LogReader logReader;
+    if (!logReader.open(logPath)) {
+        return -1;
+    }
+
+    // Load a bounded number of frames, the encoders then run on the exact same input
+    std::vector<cv::Mat> frames;
+    DataSaver::LogEntry entry;
+    for (size_t i = 0; i < logReader.recordCount() && frames.size() < maxFrames; ++i) {
+        if (logReader.readRecord(i, entry) && !entry.image.empty()) {
+            frames.push_back(entry.image.clone());
+        }
+    }
+    if (frames.empty()) {
+        std::cerr << "No camera images found in " << logPath << std::endl;
+        return -1;
+    }
+
+    const size_t rawBytes = frames[0].total() * frames[0].elemSize();
+    printf("%zu frames of %dx%d, %zu raw bytes each\n\n", frames.size(), frames[0].cols, frames[0].rows, rawBytes);
+
+    std::vector<CodecCase> cases = {
+        {"raw", makeOptions(DataSaver::LogImageEncoding::RAW)},
+        {"jpeg q95", makeOptions(DataSaver::LogImageEncoding::JPEG, 95)},
+        {"jpeg q80", makeOptions(DataSaver::LogImageEncoding::JPEG, 80)},
+        {"png level 0", makeOptions(DataSaver::LogImageEncoding::PNG, 90, 0)},
+        {"png level 1", makeOptions(DataSaver::LogImageEncoding::PNG, 90, 1)},
+        {"png level 3", makeOptions(DataSaver::LogImageEncoding::PNG, 90, 3)},
+        {"png level 6", makeOptions(DataSaver::LogImageEncoding::PNG, 90, 6)},
+        {"delta kf 30", makeOptions(DataSaver::LogImageEncoding::DELTA)},
+    };
+
+    printf("%-14s %12s %12s %14s %8s\n", "codec", "encode ms", "decode ms", "bytes/frame", "ratio");
+
+    for (const auto& codecCase : cases) {
+        DataSaver::LogImageEncoder encoder(codecCase.options);
+        std::vector<DataSaver::LogRecordHeader> headers(frames.size());
+        std::vector<std::vector<uchar>> encoded(frames.size());
+
+        // The frame number stands in for the record offset, so DELTA frames point at their keyframe's slot
+        auto encodeStart = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < frames.size(); ++i) {
+            encoder.encode(frames[i], i, headers[i], encoded[i]);
+        }
+        double encodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - encodeStart).count();
+
+        std::map<uint64_t, cv::Mat> keyframes;
+        auto loadKeyframe = [&](uint64_t offset, cv::Mat& keyframe) {
+            auto it = keyframes.find(offset);
+            if (it == keyframes.end()) {
+                if (offset >= frames.size() || !DataSaver::decodeLogImage(headers[offset], encoded[offset].data(), keyframe)) return false;
+                keyframes[offset] = keyframe;
+                return true;
+            }
+            keyframe = it->second;
+            return true;
+        };
+
+        size_t totalBytes = 0;
+        size_t failures = 0;
+        cv::Mat decoded;
+        auto decodeStart = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < frames.size(); ++i) {
+            totalBytes += encoded[i].size();
+            if (!DataSaver::decodeLogImage(headers[i], encoded[i].data(), decoded, loadKeyframe)) {
+                ++failures;
+            }
+        }
+        double decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - decodeStart).count();
+
+        double bytesPerFrame = static_cast<double>(totalBytes) / frames.size();
+        printf("%-14s %12.2f %12.2f %14.0f %8.2f%s\n",
+               codecCase.name.c_str(),
+               encodeMs / frames.size(),
+               decodeMs / frames.size(),
+               bytesPerFrame,
+               rawBytes / bytesPerFrame,
+               failures ? "  (decode failures)" : "");
+    }
+
+    return 0;
+}
@@ -127,8 +127,8 @@ int main() {
   while (not (status[0] & (1 << 1))) {
     i2c_master_read_data(fd, i2c_slave_mem_addr::STATUS_ADDR, status, sizeof(status));
 
-    i2c_master_read_logs(fd, logs);
-    i2c_master_print_logs(logs, sizeof(logs));
+    size_t newLogCount = i2c_master_read_new_logs(fd, logs, sizeof(logs));
+    i2c_master_print_logs(logs, newLogCount);
 
     std::this_thread::sleep_for(std::chrono::milliseconds(50));
   }
@@ -155,8 +155,8 @@ int main() {
     memcpy(movement + sizeof(motorPercent), &steeringPercent, sizeof(steeringPercent));
     i2c_master_send_data(fd, i2c_slave_mem_addr::MOVEMENT_INFO_ADDR, movement, sizeof(movement));
 
-    i2c_master_read_logs(fd, logs);
-    i2c_master_print_logs(logs, sizeof(logs));
+    size_t newLogCount = i2c_master_read_new_logs(fd, logs, sizeof(logs));
+    i2c_master_print_logs(logs, newLogCount);
 
 
     // Render window
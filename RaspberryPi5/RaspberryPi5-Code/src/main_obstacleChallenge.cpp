@@ -1,6 +1,8 @@
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <csignal>
+#include <filesystem>
 #include <iostream>
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc.hpp>
@@ -16,8 +18,13 @@
 #include "utils/i2c_master.h"
 #include "utils/lccv.hpp"
 #include "utils/lidarController.h"
+#include "utils/colorLookupTable.h"
 #include "utils/lidarDataProcessor.h"
+#include "utils/lidarRasterizer.h"
+#include "utils/rateScheduler.h"
 #include "utils/dataSaver.h"
+#include "utils/trace.h"
+#include "utils/tripleBuffer.h"
 
 const int BUTTON_PIN = 23;
 const uint8_t PICO_ADDRESS = 0x39;
@@ -32,6 +39,8 @@ const float LIDAR_SCALE = 180.0;
 
 const cv::Point CENTER(WIDTH/2, HEIGHT/2);
 
+const char* COLOR_TABLE_PATH = "config/colorTable.bin";
+
 
 uint32_t camWidth = 1296;
 uint32_t camHeight = 972;
@@ -39,13 +48,52 @@ uint32_t camHeight = 972;
 
 float lastGyroYaw = 0.0f;
 float accumulateGyroYaw = 0.0f;
+uint32_t lastImuSequence = 0;
+uint64_t droppedImuSamples = 0;
+
+std::atomic<bool> isRunning{true};
+
+// Control steps run at this fixed rate on the newest camera and lidar results
+const double CONTROL_RATE_HZ = 50.0;
 
-bool isRunning = true;
+// Core 0 is left to the kernel and the lidar driver thread. Pinning and SCHED_FIFO are skipped with a
+// message when the process lacks the permission.
+const bool USE_REALTIME_SCHEDULING = true;
+const int CONTROL_CPU = 1;
+const int CAMERA_CPU = 2;
+const int LIDAR_CPU = 3;
+const int CONTROL_PRIORITY = 50;
+
+// What the camera thread hands to the control loop
+struct CameraStageResult {
+    CameraPerception perception;
+    cv::Mat croppedImage;  // Bottom half of the frame for the log
+};
 
 void interuptHandler(int signum) {
     isRunning = false;
 }
 
+// Integrates the heading over every sample in order, so no turn between two control steps is missed
+void accumulateImuSamples(const imu_sample_t* samples, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const imu_sample_t& sample = samples[i];
+        if (lastImuSequence != 0 && sample.sequence != lastImuSequence + 1) {
+            droppedImuSamples += sample.sequence - lastImuSequence - 1;
+        }
+        lastImuSequence = sample.sequence;
+
+        float deltaYaw = sample.euler_data.h - lastGyroYaw;
+        if (deltaYaw > 180.0f) {
+            deltaYaw -= 360.0f;
+        } else if (deltaYaw < -180.0f) {
+            deltaYaw += 360.0f;
+        }
+        accumulateGyroYaw += deltaYaw;
+        lastGyroYaw = sample.euler_data.h;
+    }
+}
+
 
 // Draw all lines with different colors based on direction (NORTH, EAST, SOUTH, WEST)
 void drawAllLines(const std::vector<cv::Vec4i> &lines, cv::Mat &outputImage, double gyroYaw) {
@@ -99,6 +147,7 @@ int main() {
     cam.options->setExposureMode(Exposure_Modes::EXPOSURE_SHORT);
     // cam.options->setWhiteBalance(WhiteBalance_Modes::WB_DAYLIGHT);
     cam.options->verbose = true;
+    cam.options->transform = libcamera::Transform::Rot180; // Camera is mounted upside down
     cam.startVideo();
 
 
@@ -138,8 +187,12 @@ int main() {
     while (not(status[0] & (1 << 1))) {
         i2c_master_read_status(fd, status);
 
-        i2c_master_read_logs(fd, logs);
-        i2c_master_print_logs(logs, sizeof(logs));
+        size_t newLogCount;
+        {
+            TRACE_SCOPE("i2c.readLogs");
+            newLogCount = i2c_master_read_new_logs(fd, logs, sizeof(logs));
+        }
+        i2c_master_print_logs(logs, newLogCount);
 
         std::this_thread::sleep_for(std::chrono::milliseconds(50));
     }
@@ -161,7 +214,7 @@ int main() {
 
 
     lidarController::LidarController lidar;
-    if (!lidar.initialize() || !lidar.startScanning()) {
+    if (!lidar.initialize() || !lidar.startScanning() || !lidar.startStreaming()) {
         return -1;
     }
 
@@ -170,81 +223,194 @@ int main() {
     }
     delay(500);
 
-    bno055_accel_float_t initial_accel_data;
-    bno055_euler_float_t initial_euler_data;
-    i2c_master_read_bno055_accel_and_euler(fd, &initial_accel_data, &initial_euler_data);
-
-    lastGyroYaw = initial_euler_data.h;
+    // Each control step ends with one exchange that sends its movement and reads the IMU for the next step
+    i2c_exchange_t exchange = {};
+    i2c_master_read_bno055_accel_and_euler(fd, &exchange.accel_data, &exchange.euler_data);
 
-    ObstacleChallenge challenge = ObstacleChallenge(LIDAR_SCALE, CENTER);
+    lastGyroYaw = exchange.euler_data.h;
 
+    // The challenge sees the scheduler's deadline grid as its clock, so every PID step gets a whole number of periods
+    RateScheduler controlScheduler(CONTROL_RATE_HZ);
+    ObstacleChallenge challenge = ObstacleChallenge(LIDAR_SCALE, CENTER, [&controlScheduler] { return static_cast<float>(controlScheduler.stepTime()); });
 
-    while (isRunning) {
-        cv::Mat rawCameraImage;
-        if(!cam.getVideoFrame(rawCameraImage, 1000)){
-            std::cout<<"Timeout error"<<std::endl;
+    // A table made with BuildColorTable replaces the compiled-in color ranges without a rebuild,
+    // without one the exact HSV ranges are used
+    if (std::filesystem::exists(COLOR_TABLE_PATH)) {
+        ColorLookupTable colorTable;
+        if (colorTable.load(COLOR_TABLE_PATH)) {
+            challenge.setColorLookupTable(std::move(colorTable));
         }
-        cv::Mat cameraImage;
-        cv::flip(rawCameraImage, cameraImage, -1);
- 
-
-
-        bno055_accel_float_t accel_data;
-        bno055_euler_float_t euler_data;
-        i2c_master_read_bno055_accel_and_euler(fd, &accel_data, &euler_data);
+    }
 
-        float deltaYaw = euler_data.h - lastGyroYaw;
-        if (deltaYaw > 180.0f) {
-            deltaYaw -= 360.0f;
-        } else if (deltaYaw < -180.0f) {
-            deltaYaw += 360.0f;
-        }
-        accumulateGyroYaw += deltaYaw;
-        lastGyroYaw = euler_data.h;
+    DataSaver::LogWriter logWriter;
+    if (!logWriter.open("log/obstacle_" + timestamp + ".bin")) {
+        return -1;
+    }
 
-        // printf("accumulateGyroYaw: %.2f, test: %.2f, ", accumulateGyroYaw, fmod(accumulateGyroYaw*1.007274762 + 360.0f*20, 360.0f));
 
+    // Camera and lidar perception each run on their own thread and publish their newest result.
+    // The control loop fuses whatever is newest at a fixed rate, so a frame waits for the slowest stage
+    // instead of for the sum of all stages.
+    TripleBuffer<CameraStageResult> cameraResults;
+    TripleBuffer<LidarPerception> lidarResults;
+    for (auto& lidarResult : lidarResults.allBuffers()) {
+        lidarResult.binaryImage = cv::Mat::zeros(HEIGHT, WIDTH, CV_8UC1);
+        lidarController::LidarController::reserveScanBuffer(lidarResult.scan);
+    }
 
-        i2c_master_read_logs(fd, logs);
-        i2c_master_print_logs(logs, sizeof(logs));
+    std::thread cameraThread([&] {
+        if (USE_REALTIME_SCHEDULING) RateScheduler::pinToCpu(CAMERA_CPU);
+        lccv::FrameLease cameraFrame;
+        uint64_t frameCount = 0;
+        while (isRunning) {
+            bool gotFrame;
+            {
+                TRACE_SCOPE("camera.leaseVideoFrame");
+                gotFrame = cam.leaseVideoFrame(cameraFrame, 1000);
+            }
+            if(!gotFrame){
+                std::cout<<"Timeout error"<<std::endl;
+                continue;
+            }
+            TRACE_SCOPE("camera.stage");
+
+            const cv::Mat& cameraImage = cameraFrame.image();
+            CameraStageResult& result = cameraResults.writeBuffer();
+            result.perception.timestampNs = trace::nowNs();
+            result.perception.sequence = ++frameCount;
+            challenge.perceiveCamera(cameraImage, result.perception);
+
+            // The log keeps the bottom half, copied out so the camera buffer can go back right away
+            int cropHeight = static_cast<int>(cameraImage.rows * 0.50);
+            cameraImage(cv::Rect(0, cropHeight, cameraImage.cols, cameraImage.rows - cropHeight)).copyTo(result.croppedImage);
+            cameraFrame.release();
+            cameraResults.publish();
+        }
+    });
+
+    std::thread lidarThread([&] {
+        if (USE_REALTIME_SCHEDULING) RateScheduler::pinToCpu(LIDAR_CPU);
+        LidarRasterizer lidarRasterizer(WIDTH, HEIGHT, LIDAR_SCALE);
+        uint64_t lastSequence = 0;
+        while (isRunning) {
+            const auto& lidarScan = lidar.getLatestScan();
+            if (lidarScan.sequence == lastSequence) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                continue;
+            }
+            lastSequence = lidarScan.sequence;
+            TRACE_SCOPE("lidar.stage");
+
+            LidarPerception& result = lidarResults.writeBuffer();
+            result.timestampNs = trace::toNs(lidarScan.timestamp);
+            result.sequence = lidarScan.sequence;
+            result.scan = lidarScan.nodes;
+
+            // Each slot has its own image, only its previous points need clearing
+            lidarRasterizer.rasterize(result.scan);
+            if (!result.roi.empty()) {
+                result.binaryImage(result.roi).setTo(0);
+            }
+            result.roi = lidarRasterizer.roi();
+            if (!result.roi.empty()) {
+                lidarRasterizer.roiImage().copyTo(result.binaryImage(result.roi));
+            }
+
+            challenge.perceiveLidar(result);
+            lidarResults.publish();
+        }
+    });
 
-        auto lidarScanData = lidar.getScanData();
-        cv::Mat binaryImage = lidarDataToImage(lidarScanData, WIDTH, HEIGHT, LIDAR_SCALE);
+    // Only this thread runs SCHED_FIFO, the stage threads above were created before it switched
+    if (USE_REALTIME_SCHEDULING) {
+        RateScheduler::pinToCpu(CONTROL_CPU);
+        RateScheduler::setRealtimePriority(CONTROL_PRIORITY);
+    }
 
-        challenge.update(binaryImage, cameraImage, fmod(accumulateGyroYaw*1.0065+ 360.0f*20, 360.0f), motorPercent, steeringPercent);
-        steeringPercent = std::clamp(steeringPercent, -1.0f, 1.0f);
+    // Sends the movement and takes in the IMU samples and logs the Pico produced since the last exchange
+    auto exchangeWithPico = [&](float motor, float steering) {
+        bool exchanged;
+        uint64_t exchangeStartNs = trace::nowNs();
+        {
+            TRACE_SCOPE("i2c.exchange");
+            exchanged = i2c_master_exchange(fd, PICO_ADDRESS, motor, steering, &exchange);
+        }
+        if (!exchanged) return;
+
+        accumulateImuSamples(exchange.imu_samples, exchange.imu_samples_received);
+        if (exchange.imu_samples_received > 0) {
+            // Both times are on the Pico clock, the difference is how old the heading is.
+            // A sample can only be newer if the ring overflowed during the transfer.
+            uint64_t sampleTimestampUs = exchange.imu_samples[exchange.imu_samples_received - 1].timestamp_us;
+            uint64_t sampleAgeUs = exchange.time_us > sampleTimestampUs ? exchange.time_us - sampleTimestampUs : 0;
+            TRACE_EVENT("imu.sampleAge", exchangeStartNs - sampleAgeUs * 1000, exchangeStartNs);
+        }
 
+        // Logs cost a second transaction only on the steps where the Pico wrote some
+        if (exchange.logs_count > 0) {
+            size_t newLogCount = std::min<size_t>(exchange.logs_count, sizeof(logs));
+            {
+                TRACE_SCOPE("i2c.readLogs");
+                i2c_master_read_logs(fd, logs, newLogCount);
+            }
+            i2c_master_print_logs(logs, newLogCount);
+        }
+    };
+
+    // Samples from before the start only set the baseline heading
+    imu_sample_t imuSamples[i2c_slave_mem_addr::IMU_SAMPLES_BUFFER_SIZE];
+    size_t imuSampleCount = i2c_master_drain_imu_samples(fd, imuSamples, i2c_slave_mem_addr::IMU_SAMPLES_BUFFER_SIZE);
+    if (imuSampleCount > 0) {
+        lastGyroYaw = imuSamples[imuSampleCount - 1].euler_data.h;
+        lastImuSequence = imuSamples[imuSampleCount - 1].sequence;
+    }
 
-        int cropHeight = static_cast<int>(cameraImage.rows * 0.50);
-        cv::Rect cropRegion(0, cropHeight, cameraImage.cols, cameraImage.rows - cropHeight);
-        cv::Mat croppedImage = cameraImage(cropRegion);
-        if (DataSaver::saveLogData("log/obstacle_" + timestamp + ".bin", lidarScanData, accel_data, euler_data, croppedImage)) {
-            // std::cout << "Log data saved to file successfully." << std::endl;
-        } else {
-            std::cerr << "Failed to save log data to file." << std::endl;
+    controlScheduler.start();
+    while (isRunning) {
+        controlScheduler.waitNext();
+        TRACE_SCOPE("loop");
+
+        bool freshCamera = cameraResults.update();
+        bool freshLidar = lidarResults.update();
+        const CameraStageResult& camera = cameraResults.readBuffer();
+        const LidarPerception& lidarResult = lidarResults.readBuffer();
+        // Nothing to steer by until both stages delivered once, the robot stands still and the IMU ring keeps draining
+        if (camera.perception.sequence == 0 || lidarResult.sequence == 0) {
+            exchangeWithPico(0.0f, 0.0f);
+            continue;
         }
+        uint64_t controlStartNs = trace::nowNs();
+        TRACE_EVENT("camera.resultAge", camera.perception.timestampNs, controlStartNs);
+        TRACE_EVENT("lidar.scanAge", lidarResult.timestampNs, controlStartNs);
 
 
-        // motorPercent = 0.0f;
-        // steeringPercent = 0.0f;
-        // Send movement data via I2C
-        uint8_t movement[sizeof(motorPercent) + sizeof(steeringPercent)];
+        const bno055_accel_float_t& accel_data = exchange.accel_data;
+        const bno055_euler_float_t& euler_data = exchange.euler_data;
 
-        memcpy(movement, &motorPercent, sizeof(motorPercent));
-        memcpy(movement + sizeof(motorPercent), &steeringPercent, sizeof(steeringPercent));
-        i2c_master_send_data(fd, i2c_slave_mem_addr::MOVEMENT_INFO_ADDR, movement, sizeof(movement));
+        challenge.update(lidarResult, camera.perception, fmod(accumulateGyroYaw*1.0065+ 360.0f*20, 360.0f), motorPercent, steeringPercent);
+        steeringPercent = std::clamp(steeringPercent, -1.0f, 1.0f);
 
 
+        // One record per new camera frame or scan, steps that only saw old results add nothing to replay
+        if (freshCamera || freshLidar) {
+            bool logQueued;
+            {
+                TRACE_SCOPE("log.enqueue");
+                logQueued = logWriter.enqueue(lidarResult.scan, accel_data, euler_data, camera.croppedImage);
+            }
+            if (!logQueued) {
+                std::cerr << "Log record dropped (" << logWriter.droppedCount() << " total)." << std::endl;
+            }
+        }
 
-        // cv::imshow("libcamera-demo", cameraImage);
-        // cv::imshow("LIDAR Hough Lines", filterAllColors(cameraImage));
 
-        // char key = cv::waitKey(1);
-        // if (key == 'q') {
-        //     break;
-        // }
+        // Send movement data and read the IMU and logs via I2C, the yaw for the next step integrates
+        // every sample the Pico took since the last exchange
+        exchangeWithPico(motorPercent, steeringPercent);
     }
 
+    cameraThread.join();
+    lidarThread.join();
     motorPercent = 0.0f;
     steeringPercent = 0.0f;
 
@@ -259,5 +425,15 @@ int main() {
 
     lidar.shutdown();
 
+    logWriter.close();
+    std::cout << "Log records queued: " << logWriter.queuedCount()
+              << ", written: " << logWriter.writtenCount()
+              << ", dropped: " << logWriter.droppedCount() << std::endl;
+
+    controlScheduler.printStats(std::cout);
+    std::cout << "IMU samples dropped: " << droppedImuSamples << std::endl;
+    trace::printStats(std::cout);
+    trace::writeChromeTrace("log/trace_obstacle_" + timestamp + ".json");
+
     return 0;
 }
@@ -1,12 +1,14 @@
 #include <chrono>
 #include <cmath>
 #include <csignal>
+#include <iomanip>
 #include <iostream>
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/core.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/highgui.hpp>
+#include <sstream>
 #include <thread>
 #include <vector>
 #include <wiringPi.h>
@@ -18,6 +20,7 @@
 #include "utils/lidarController.h"
 #include "utils/lidarDataProcessor.h"
 #include "utils/dataSaver.h"
+#include "utils/trace.h"
 
 const int BUTTON_PIN = 23;
 const uint8_t PICO_ADDRESS = 0x39;
@@ -77,6 +80,14 @@ void drawAllLines(const std::vector<cv::Vec4i> &lines, cv::Mat &outputImage, dou
 int main() {
     signal(SIGINT, interuptHandler);
 
+    std::time_t now = std::time(nullptr);
+    std::tm localTime;
+    localtime_r(&now, &localTime); // Use `localtime_r` for thread-safe conversion
+
+    std::ostringstream timestampStream;
+    timestampStream << std::put_time(&localTime, "%Y%m%d_%H%M%S"); // Format: YYYYMMDD_HHMMSS
+    std::string timestamp = timestampStream.str();
+
     // cv::namedWindow("LIDAR Hough Lines", cv::WINDOW_AUTOSIZE);
 
 
@@ -128,8 +139,12 @@ int main() {
     while (not(status[0] & (1 << 1))) {
         i2c_master_read_status(fd, status);
 
-        i2c_master_read_logs(fd, logs);
-        i2c_master_print_logs(logs, sizeof(logs));
+        size_t newLogCount;
+        {
+            TRACE_SCOPE("i2c.readLogs");
+            newLogCount = i2c_master_read_new_logs(fd, logs, sizeof(logs));
+        }
+        i2c_master_print_logs(logs, newLogCount);
 
         std::this_thread::sleep_for(std::chrono::milliseconds(50));
     }
@@ -151,7 +166,7 @@ int main() {
 
 
     lidarController::LidarController lidar;
-    if (!lidar.initialize() || !lidar.startScanning()) {
+    if (!lidar.initialize() || !lidar.startScanning() || !lidar.startStreaming()) {
         return -1;
     }
 
@@ -167,8 +182,21 @@ int main() {
     lastGyroYaw = initial_euler_data.h;
 
     OpenChallenge challenge = OpenChallenge(LIDAR_SCALE, CENTER);
+    uint64_t lastScanSequence = 0;
 
     while (isRunning) {
+        // Nothing else paces this loop, so only run once per new LIDAR rotation
+        const auto& lidarScan = lidar.getLatestScan();
+        if (lidarScan.sequence == lastScanSequence) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        lastScanSequence = lidarScan.sequence;
+
+        TRACE_SCOPE("loop");
+        TRACE_EVENT("lidar.scanAge", trace::toNs(lidarScan.timestamp), trace::nowNs());
+        const auto& lidarScanData = lidarScan.nodes;
+
         // cv::Mat rawCameraImage;
         // if(!cam.getVideoFrame(rawCameraImage, 1000)){
         //     std::cout<<"Timeout error"<<std::endl;
@@ -180,7 +208,10 @@ int main() {
 
         bno055_accel_float_t accel_data;
         bno055_euler_float_t euler_data;
-        i2c_master_read_bno055_accel_and_euler(fd, &accel_data, &euler_data);
+        {
+            TRACE_SCOPE("i2c.readImu");
+            i2c_master_read_bno055_accel_and_euler(fd, &accel_data, &euler_data);
+        }
 
         float deltaYaw = euler_data.h - lastGyroYaw;
         if (deltaYaw > 180.0f) {
@@ -194,21 +225,19 @@ int main() {
         // printf("accumulateGyroYaw: %.2f, test: %.2f, ", accumulateGyroYaw, fmod(accumulateGyroYaw*1.007274762 + 360.0f*20, 360.0f));
 
 
-        i2c_master_read_logs(fd, logs);
-        i2c_master_print_logs(logs, sizeof(logs));
+        size_t newLogCount = i2c_master_read_new_logs(fd, logs, sizeof(logs));
+        i2c_master_print_logs(logs, newLogCount);
 
-        auto lidarScanData = lidar.getScanData();
-        cv::Mat binaryImage = lidarDataToImage(lidarScanData, WIDTH, HEIGHT, LIDAR_SCALE);
-        auto lines = detectLines(binaryImage);
-        auto combined_lines = combineAlignedLines(lines);
 
 
+        // cv::Mat binaryImage = lidarDataToImage(lidarScanData, WIDTH, HEIGHT, LIDAR_SCALE);
+        // auto combined_lines = combineAlignedLines(detectScanLines(lidarScanData, WIDTH, HEIGHT, LIDAR_SCALE));
         // cv::Mat outputImage = cv::Mat::zeros(HEIGHT, WIDTH, CV_8UC3);
         // cv::cvtColor(binaryImage, outputImage, cv::COLOR_GRAY2BGR);
         // drawAllLines(combined_lines, outputImage, fmod(euler_data.h - initial_euler_data.h + 360.0f, 360.0f));
         
 
-        challenge.update(binaryImage, fmod(accumulateGyroYaw*1.007274762 + 360.0f*20, 360.0f), motorPercent, steeringPercent);
+        challenge.update(lidarScanData, fmod(accumulateGyroYaw*1.007274762 + 360.0f*20, 360.0f), motorPercent, steeringPercent);
 
 
         // int cropHeight = static_cast<int>(cameraImage.rows * 0.50);
@@ -228,7 +257,10 @@ int main() {
 
         memcpy(movement, &motorPercent, sizeof(motorPercent));
         memcpy(movement + sizeof(motorPercent), &steeringPercent, sizeof(steeringPercent));
-        i2c_master_send_data(fd, i2c_slave_mem_addr::MOVEMENT_INFO_ADDR, movement, sizeof(movement));
+        {
+            TRACE_SCOPE("i2c.sendMovement");
+            i2c_master_send_data(fd, i2c_slave_mem_addr::MOVEMENT_INFO_ADDR, movement, sizeof(movement));
+        }
 
 
 
@@ -255,5 +287,8 @@ int main() {
 
     lidar.shutdown();
 
+    trace::printStats(std::cout);
+    trace::writeChromeTrace("log/trace_open_" + timestamp + ".json");
+
     return 0;
 }
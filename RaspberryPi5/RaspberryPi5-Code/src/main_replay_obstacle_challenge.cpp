@@ -0,0 +1,132 @@
+// Runs ObstacleChallenge headless on a recorded log and writes its outputs as CSV
+// Usage: ReplayObstacleChallenge [log file] [output csv] [color table]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "challenges/obstacleChallenge.h"
+#include "utils/dataSaver.h"
+#include "utils/colorLookupTable.h"
+#include "utils/lidarDataProcessor.h"
+#include "utils/lidarRasterizer.h"
+#include "utils/trace.h"
+
+const int WIDTH = 1200;
+const int HEIGHT = 1200;
+const float LIDAR_SCALE = 180.0;
+
+const cv::Point CENTER(WIDTH/2, HEIGHT/2);
+
+const char* COLOR_TABLE_PATH = "config/colorTable.bin";
+
+// Legacy logs have no timestamps, assume the camera rate of the robot loop
+const float LEGACY_FRAME_PERIOD = 1.0f / 30.0f;
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    const char* logPath = argc > 1 ? argv[1] : "log/logData3.bin";
+
+    std::ofstream csvFile;
+    if (argc > 2) {
+        csvFile.open(argv[2]);
+        if (!csvFile.is_open()) {
+            std::cerr << "Failed to open output file: " << argv[2] << std::endl;
+            return -1;
+        }
+    }
+    std::ostream& csv = argc > 2 ? csvFile : std::cout;
+
+    DataSaver::LogReader logReader;
+    if (!logReader.open(logPath) || logReader.recordCount() == 0) {
+        std::cerr << "No scan data found in file or failed to load." << std::endl;
+        return -1;
+    }
+
+    DataSaver::LogEntry logEntry;
+    if (!logReader.readRecord(0, logEntry, false)) {
+        std::cerr << "Failed to read the first record." << std::endl;
+        return -1;
+    }
+
+    // The challenge reads the time of the record being replayed, so runs are repeatable
+    bool hasTimestamps = logReader.version() > 0;
+    int64_t firstTimestampUs = logEntry.timestampUs;
+    // Start one frame early so the first update sees a real time step instead of zero
+    float replayTime = -LEGACY_FRAME_PERIOD;
+    ObstacleChallenge challenge = ObstacleChallenge(LIDAR_SCALE, CENTER, [&replayTime] { return replayTime; });
+    LidarRasterizer lidarRasterizer(WIDTH, HEIGHT, LIDAR_SCALE);
+
+    // Same color table choice as main_obstacleChallenge.cpp, a table given on the command line must load
+    const char* colorTablePath = argc > 3 ? argv[3] : COLOR_TABLE_PATH;
+    if (argc > 3 || std::filesystem::exists(colorTablePath)) {
+        ColorLookupTable colorTable;
+        if (!colorTable.load(colorTablePath)) {
+            return -1;
+        }
+        challenge.setColorLookupTable(std::move(colorTable));
+    }
+
+    // Same yaw accumulation as main_obstacleChallenge.cpp
+    float lastGyroYaw = logEntry.euler_data.h;
+    float accumulateGyroYaw = 0.0f;
+
+    float motorPercent = 0.0f;
+    float steeringPercent = 0.0f;
+
+    csv << "frame,time_s,gyro_yaw,motor,steering,read_ms,rasterize_ms,update_ms" << std::endl;
+
+    for (size_t frame = 0; frame < logReader.recordCount(); ++frame) {
+        auto readStart = std::chrono::steady_clock::now();
+        if (!logReader.readRecord(frame, logEntry)) {
+            std::cerr << "Failed to read frame " << frame << ", stopping." << std::endl;
+            break;
+        }
+
+        // The log holds the bottom half of the frame, processImage expects the full height
+        cv::Mat cameraImage;
+        if (!logEntry.image.empty()) {
+            cameraImage = cv::Mat::zeros(logEntry.image.rows * 2, logEntry.image.cols, logEntry.image.type());
+            logEntry.image.copyTo(cameraImage(cv::Rect(0, logEntry.image.rows, logEntry.image.cols, logEntry.image.rows)));
+        }
+        double readMs = elapsedMs(readStart);
+
+        replayTime = hasTimestamps ? (logEntry.timestampUs - firstTimestampUs) / 1e6f : frame * LEGACY_FRAME_PERIOD;
+
+        float deltaYaw = logEntry.euler_data.h - lastGyroYaw;
+        if (deltaYaw > 180.0f) {
+            deltaYaw -= 360.0f;
+        } else if (deltaYaw < -180.0f) {
+            deltaYaw += 360.0f;
+        }
+        accumulateGyroYaw += deltaYaw;
+        lastGyroYaw = logEntry.euler_data.h;
+        float gyroYaw = fmod(accumulateGyroYaw*1.0065+ 360.0f*20, 360.0f);
+
+        auto rasterizeStart = std::chrono::steady_clock::now();
+        const cv::Mat& binaryImage = lidarRasterizer.rasterize(logEntry.scanData);
+        double rasterizeMs = elapsedMs(rasterizeStart);
+
+        auto updateStart = std::chrono::steady_clock::now();
+        challenge.update(logEntry.scanData, binaryImage, lidarRasterizer.roi(), cameraImage, gyroYaw, motorPercent, steeringPercent);
+        double updateMs = elapsedMs(updateStart);
+        steeringPercent = std::clamp(steeringPercent, -1.0f, 1.0f);
+
+        csv << frame << ',' << replayTime << ',' << gyroYaw << ',' << motorPercent << ',' << steeringPercent << ','
+            << readMs << ',' << rasterizeMs << ',' << updateMs << '\n';
+    }
+
+    csv.flush();
+
+    // Per-stage breakdown of the update, the CSV keeps the per-frame totals
+    trace::printStats(std::cerr);
+    return 0;
+}
@@ -4,17 +4,23 @@ public:
         : kp(kp), ki(ki), kd(kd), prevError(0.0f), integral(0.0f) {}
 
     float calculate(float error, float deltaTime) {
-        integral += error * deltaTime;
-        float derivative = (error - prevError) / deltaTime;
-        prevError = error;
+        // Two calls on (almost) the same timestamp would divide by ~0, keep the last terms instead
+        if (deltaTime > MIN_DELTA_TIME) {
+            integral += error * deltaTime;
+            derivative = (error - prevError) / deltaTime;
+            prevError = error;
+        }
 
         return kp * error + ki * integral + kd * derivative;
     }
 
 private:
+    static constexpr float MIN_DELTA_TIME = 1e-4f;  // Seconds
+
     float kp;         // Proportional coefficient
     float ki;         // Integral coefficient
     float kd;         // Derivative coefficient
     float prevError;  // Previous error
     float integral;   // Accumulated integral
+    float derivative = 0.0f;  // Last derivative
 };
@@ -0,0 +1,109 @@
+#include "colorLookupTable.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "trace.h"
+
+static const char TABLE_FILE_MAGIC[4] = {'C', 'L', 'U', 'T'};
+
+bool ColorLookupTable::build(const std::vector<ColorRange> &ranges, int bitsPerChannel) {
+    if (bitsPerChannel < 1 || bitsPerChannel > 8) {
+        std::cerr << "Invalid color table bits per channel: " << bitsPerChannel << std::endl;
+        return false;
+    }
+
+    // One pixel per cell: row is the blue cell, column is green cell * size + red cell
+    int size = 1 << bitsPerChannel;
+    int shift = 8 - bitsPerChannel;
+    int half = (1 << shift) / 2;
+    cv::Mat centers(size, size * size, CV_8UC3);
+    for (int b = 0; b < size; b++) {
+        cv::Vec3b *row = centers.ptr<cv::Vec3b>(b);
+        for (int g = 0; g < size; g++) {
+            for (int r = 0; r < size; r++) {
+                row[g * size + r] = cv::Vec3b((b << shift) + half, (g << shift) + half, (r << shift) + half);
+            }
+        }
+    }
+
+    cv::Mat hsvCenters, labels = cv::Mat::zeros(centers.size(), CV_8UC1), mask;
+    cv::cvtColor(centers, hsvCenters, cv::COLOR_BGR2HSV);
+    for (const auto &range : ranges) {
+        cv::inRange(hsvCenters, range.lower, range.upper, mask);
+        cv::bitwise_or(labels, cv::Scalar(range.label), labels, mask);
+    }
+
+    bits = bitsPerChannel;
+    table.assign(labels.data, labels.data + labels.total());
+    return true;
+}
+
+bool ColorLookupTable::save(const std::string &filePath) const {
+    if (empty()) {
+        std::cerr << "Color table is empty, nothing to save." << std::endl;
+        return false;
+    }
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for saving color table: " << filePath << std::endl;
+        return false;
+    }
+
+    uint32_t fileBits = bits;
+    file.write(TABLE_FILE_MAGIC, sizeof(TABLE_FILE_MAGIC));
+    file.write(reinterpret_cast<const char *>(&fileBits), sizeof(fileBits));
+    file.write(reinterpret_cast<const char *>(table.data()), table.size());
+
+    if (!file) {
+        std::cerr << "Failed to save color table to file." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool ColorLookupTable::load(const std::string &filePath) {
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for loading color table: " << filePath << std::endl;
+        return false;
+    }
+
+    char magic[sizeof(TABLE_FILE_MAGIC)];
+    uint32_t fileBits = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char *>(&fileBits), sizeof(fileBits));
+    if (!file || std::memcmp(magic, TABLE_FILE_MAGIC, sizeof(magic)) != 0 || fileBits < 1 || fileBits > 8) {
+        std::cerr << "Invalid or corrupt color table header in file." << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> fileTable(size_t(1) << (3 * fileBits));
+    file.read(reinterpret_cast<char *>(fileTable.data()), fileTable.size());
+    if (!file) {
+        std::cerr << "Failed to read color table from file." << std::endl;
+        return false;
+    }
+
+    bits = fileBits;
+    table = std::move(fileTable);
+    return true;
+}
+
+void ColorLookupTable::classify(const cv::Mat &image, cv::Mat &labels) const {
+    TRACE_SCOPE("ColorLookupTable::classify");
+    labels.create(image.size(), CV_8UC1);
+
+    cv::parallel_for_(cv::Range(0, image.rows), [&](const cv::Range &rows) {
+        for (int y = rows.start; y < rows.end; y++) {
+            const cv::Vec3b *imageRow = image.ptr<cv::Vec3b>(y);
+            uchar *labelRow = labels.ptr<uchar>(y);
+            for (int x = 0; x < image.cols; x++) {
+                labelRow[x] = lookup(imageRow[x][0], imageRow[x][1], imageRow[x][2]);
+            }
+        }
+    });
+}
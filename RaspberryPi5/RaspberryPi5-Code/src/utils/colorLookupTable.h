@@ -0,0 +1,53 @@
+#ifndef COLOR_LOOKUP_TABLE_H
+#define COLOR_LOOKUP_TABLE_H
+
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+#include "imageProcessor.h"
+
+/**
+ * @brief Quantized BGR -> label table, so a pixel is classified with one lookup instead of an HSV conversion.
+ *
+ * Each channel is cut to bitsPerChannel bits and every cell holds the LABEL_* bits of its center color,
+ * computed once with the same cvtColor + inRange rule as classifyColors. Only colors within half a cell of a
+ * range border can get a different label. 6 bits (64^3 cells, 256 KiB) keeps the table in the Pi's L2 cache,
+ * 8 bits is exact but takes 16 MiB. New color ranges only need a table file made with BuildColorTable
+ * (src/main_build_color_table.cpp), no recompile.
+ */
+class ColorLookupTable {
+public:
+    static const int DEFAULT_BITS_PER_CHANNEL = 6;
+
+    ColorLookupTable() = default;
+
+    /**
+     * @brief Fills the table from HSV ranges.
+     * @param bitsPerChannel Between 1 and 8.
+     */
+    bool build(const std::vector<ColorRange> &ranges, int bitsPerChannel = DEFAULT_BITS_PER_CHANNEL);
+
+    bool save(const std::string &filePath) const;
+    bool load(const std::string &filePath);
+
+    bool empty() const { return table.empty(); }
+    int bitsPerChannel() const { return bits; }
+
+    uint8_t lookup(uchar b, uchar g, uchar r) const {
+        int shift = 8 - bits;
+        return table[((b >> shift) << (2 * bits)) | ((g >> shift) << bits) | (r >> shift)];
+    }
+
+    /**
+     * @brief Same output as classifyColors: a CV_8UC1 image of LABEL_* bits for a BGR image.
+     */
+    void classify(const cv::Mat &image, cv::Mat &labels) const;
+
+private:
+    int bits = 0;
+    std::vector<uint8_t> table;
+};
+
+#endif // COLOR_LOOKUP_TABLE_H
@@ -1,6 +1,8 @@
 #include "dataSaver.h"
 
-#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <filesystem>  // For creating directories
 
@@ -71,6 +73,195 @@ bool loadData(const std::string& filePath, uint8_t calibData[22]) {
     return true;
 }
 
+static int64_t steadyTimestampUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void writeLogFileHeader(std::ostream& file) {
+    LogFileHeader header{};
+    memcpy(header.magic, LOG_FILE_MAGIC, sizeof(header.magic));
+    header.version = LOG_FORMAT_VERSION;
+    header.headerSize = sizeof(LogFileHeader);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+static bool isLogFileHeader(const LogFileHeader& header) {
+    return memcmp(header.magic, LOG_FILE_MAGIC, sizeof(header.magic)) == 0;
+}
+
+LogImageEncoder::LogImageEncoder(const LogImageOptions& options) : options(options) {
+    if (options.encoding == LogImageEncoding::JPEG) {
+        params = {cv::IMWRITE_JPEG_QUALITY, options.jpegQuality};
+    } else if (options.encoding == LogImageEncoding::PNG || options.encoding == LogImageEncoding::DELTA) {
+        params = {cv::IMWRITE_PNG_COMPRESSION, options.pngCompression};
+    }
+}
+
+void LogImageEncoder::reset() {
+    keyframe.release();
+    framesSinceKeyframe = 0;
+}
+
+bool LogImageEncoder::encode(const cv::Mat& image, uint64_t recordOffset, LogRecordHeader& header, std::vector<uchar>& buffer) {
+    buffer.clear();
+    header.imageRows = image.rows;
+    header.imageCols = image.cols;
+    header.imageType = image.type();
+
+    if (image.empty()) {
+        header.imageEncoding = static_cast<uint32_t>(LogImageEncoding::NONE);
+        header.imageSize = 0;
+        return true;
+    }
+
+    LogImageEncoding encoding = options.encoding;
+    bool success = true;
+
+    switch (encoding) {
+        case LogImageEncoding::NONE:
+            break;
+
+        case LogImageEncoding::RAW: {
+            size_t rowSize = image.cols * image.elemSize();
+            buffer.resize(rowSize * image.rows);
+            for (int row = 0; row < image.rows; ++row) {
+                memcpy(buffer.data() + row * rowSize, image.ptr(row), rowSize);
+            }
+            break;
+        }
+
+        case LogImageEncoding::JPEG:
+            success = cv::imencode(".jpg", image, buffer, params);
+            break;
+
+        case LogImageEncoding::PNG:
+            success = cv::imencode(".png", image, buffer, params);
+            break;
+
+        case LogImageEncoding::DELTA: {
+            bool needKeyframe = keyframe.empty() || keyframe.size() != image.size() || keyframe.type() != image.type()
+                             || framesSinceKeyframe >= options.keyframeInterval;
+            if (needKeyframe) {
+                // Keyframes are plain PNG records that later deltas point back to
+                encoding = LogImageEncoding::PNG;
+                success = cv::imencode(".png", image, buffer, params);
+                if (success) {
+                    image.copyTo(keyframe);
+                    keyframeOffset = recordOffset;
+                    framesSinceKeyframe = 0;
+                }
+                break;
+            }
+
+            // Mostly zeros for a static scene, so it compresses far better than the frame itself
+            cv::bitwise_xor(image, keyframe, deltaImage);
+            std::vector<uchar>& encodedDelta = deltaBuffer;
+            success = cv::imencode(".png", deltaImage, encodedDelta, params);
+            if (success) {
+                buffer.resize(sizeof(uint64_t) + encodedDelta.size());
+                memcpy(buffer.data(), &keyframeOffset, sizeof(uint64_t));
+                memcpy(buffer.data() + sizeof(uint64_t), encodedDelta.data(), encodedDelta.size());
+                ++framesSinceKeyframe;
+            }
+            break;
+        }
+    }
+
+    if (!success) {
+        buffer.clear();
+        encoding = LogImageEncoding::NONE;
+    }
+    header.imageEncoding = static_cast<uint32_t>(encoding);
+    header.imageSize = buffer.size();
+    return success;
+}
+
+// Writes one record (header, scan nodes, encoded image, padding) at recordOffset and returns its size in bytes
+static uint64_t writeLogRecord(std::ostream& file,
+                               uint64_t recordOffset,
+                               int64_t timestampUs,
+                               const std::vector<lidarController::NodeData>& scanData,
+                               const bno055_accel_float_t& accel_data,
+                               const bno055_euler_float_t& euler_data,
+                               const cv::Mat& image,
+                               LogImageEncoder& encoder,
+                               std::vector<uchar>& buffer) {
+    LogRecordHeader header{};
+    header.magic = LOG_RECORD_MAGIC;
+    header.scanCount = static_cast<uint32_t>(scanData.size());
+    header.timestampUs = timestampUs;
+    header.accel = accel_data;
+    header.euler = euler_data;
+    if (!encoder.encode(image, recordOffset, header, buffer)) {
+        std::cerr << "Failed to encode log image, the record is saved without it." << std::endl;
+    }
+
+    static const char zeros[LOG_ALIGNMENT] = {};
+    uint64_t recordSize = logRecordSize(header);
+    uint64_t unpaddedSize = sizeof(header) + scanData.size() * sizeof(lidarController::NodeData) + buffer.size();
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(scanData.data()), scanData.size() * sizeof(lidarController::NodeData));
+    file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    file.write(zeros, recordSize - unpaddedSize);
+
+    return recordSize;
+}
+
+// Writes the frame index and trailer that let readers seek without walking the file
+static void writeLogIndex(std::ostream& file, uint64_t indexOffset, const std::vector<LogIndexEntry>& index) {
+    LogIndexHeader indexHeader{};
+    indexHeader.magic = LOG_INDEX_MAGIC;
+    indexHeader.recordCount = index.size();
+    file.write(reinterpret_cast<const char*>(&indexHeader), sizeof(indexHeader));
+    file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(LogIndexEntry));
+
+    LogFileTrailer trailer{};
+    trailer.indexOffset = indexOffset;
+    trailer.recordCount = index.size();
+    trailer.magic = LOG_TRAILER_MAGIC;
+    trailer.version = LOG_FORMAT_VERSION;
+    file.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+}
+
+bool decodeLogImage(const LogRecordHeader& header, const uchar* data, cv::Mat& image, const LogKeyframeLoader& loadKeyframe) {
+    switch (static_cast<LogImageEncoding>(header.imageEncoding)) {
+        case LogImageEncoding::NONE:
+            image.release();
+            return true;
+
+        case LogImageEncoding::RAW: {
+            size_t rowSize = static_cast<size_t>(header.imageCols) * CV_ELEM_SIZE(header.imageType);
+            if (header.imageSize != rowSize * header.imageRows) return false;
+            // Copied so the image does not point into a reused or mapped buffer
+            cv::Mat(header.imageRows, header.imageCols, header.imageType, const_cast<uchar*>(data)).copyTo(image);
+            return true;
+        }
+
+        case LogImageEncoding::JPEG:
+        case LogImageEncoding::PNG:
+            // Wraps the bytes without copying them
+            image = cv::imdecode(cv::Mat(1, static_cast<int>(header.imageSize), CV_8UC1, const_cast<uchar*>(data)), cv::IMREAD_UNCHANGED);
+            return !image.empty();
+
+        case LogImageEncoding::DELTA: {
+            if (header.imageSize < sizeof(uint64_t) || !loadKeyframe) return false;
+
+            uint64_t keyframeOffset;
+            memcpy(&keyframeOffset, data, sizeof(keyframeOffset));
+            cv::Mat keyframe;
+            if (!loadKeyframe(keyframeOffset, keyframe)) return false;
+
+            cv::Mat delta = cv::imdecode(cv::Mat(1, static_cast<int>(header.imageSize - sizeof(uint64_t)), CV_8UC1, const_cast<uchar*>(data + sizeof(uint64_t))), cv::IMREAD_UNCHANGED);
+            if (delta.empty() || delta.size() != keyframe.size() || delta.type() != keyframe.type()) return false;
+
+            cv::bitwise_xor(delta, keyframe, image);
+            return true;
+        }
+    }
+    return false;
+}
+
 bool saveLogData(const std::string& filePath, 
                  const std::vector<lidarController::NodeData>& scanData, 
                  const bno055_accel_float_t& accel_data, 
@@ -83,27 +274,33 @@ bool saveLogData(const std::string& filePath,
         return false;
     }
 
+    bool newFile = !append || !std::filesystem::exists(filePath) || std::filesystem::file_size(filePath) == 0;
+    if (!newFile) {
+        // Only append records to a file that already has a container header
+        LogFileHeader header{};
+        std::ifstream existing(filePath, std::ios::binary);
+        existing.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!existing || !isLogFileHeader(header)) {
+            std::cerr << "Cannot append to a legacy or unknown log file: " << filePath << std::endl;
+            return false;
+        }
+    }
+
     std::ofstream file(filePath, append ? std::ios::binary | std::ios::app : std::ios::binary | std::ios::trunc);
     if (!file.is_open()) {
         std::cerr << "Failed to open file for saving log data: " << filePath << std::endl;
         return false;
     }
 
-    // Save scan data size and contents
-    size_t dataSize = scanData.size();
-    file.write(reinterpret_cast<const char*>(&dataSize), sizeof(dataSize));
-    file.write(reinterpret_cast<const char*>(scanData.data()), dataSize * sizeof(lidarController::NodeData));
-
-    // Save accel and Euler data
-    file.write(reinterpret_cast<const char*>(&accel_data), sizeof(bno055_accel_float_t));
-    file.write(reinterpret_cast<const char*>(&euler_data), sizeof(bno055_euler_float_t));
+    if (newFile) {
+        writeLogFileHeader(file);
+    }
 
-    // Encode and save image data
+    // Records saved one at a time cannot refer to a keyframe, so always use PNG here
+    uint64_t recordOffset = newFile ? sizeof(LogFileHeader) : std::filesystem::file_size(filePath);
+    LogImageEncoder encoder;
     std::vector<uchar> buffer;
-    cv::imencode(".png", image, buffer);  // Save as PNG
-    size_t imgSize = buffer.size();
-    file.write(reinterpret_cast<const char*>(&imgSize), sizeof(imgSize));  // Save image size
-    file.write(reinterpret_cast<const char*>(buffer.data()), imgSize);     // Save image bytes
+    writeLogRecord(file, recordOffset, steadyTimestampUs(), scanData, accel_data, euler_data, image, encoder, buffer);
 
     if (!file) {
         std::cerr << "Failed to save log data to file." << std::endl;
@@ -119,61 +316,434 @@ bool loadLogData(const std::string& filePath,
                  std::vector<bno055_accel_float_t>& allAccelData, 
                  std::vector<bno055_euler_float_t>& allEulerData, 
                  std::vector<cv::Mat>& allCameraImage) {
-    std::ifstream file(filePath, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open file for loading log data: " << filePath << std::endl;
-        return false;
-    }
-
     allScanData.clear();
     allAccelData.clear();
     allEulerData.clear();
     allCameraImage.clear();
 
-    // Read data chunks
-    while (file) {
-        size_t dataSize = 0;
-        file.read(reinterpret_cast<char*>(&dataSize), sizeof(dataSize));
-        if (!file)
-            break;
+    LogReader reader;
+    if (!reader.open(filePath)) {
+        return false;
+    }
 
-        std::vector<lidarController::NodeData> scanData(dataSize);
-        file.read(reinterpret_cast<char*>(scanData.data()), dataSize * sizeof(lidarController::NodeData));
-        if (!file)
-            break;
+    LogEntry entry;
+    for (size_t i = 0; i < reader.recordCount(); ++i) {
+        if (!reader.readRecord(i, entry)) {
+            return false;
+        }
 
-        bno055_accel_float_t accel_data;
-        file.read(reinterpret_cast<char*>(&accel_data), sizeof(bno055_accel_float_t));
+        // Store the loaded data
+        allScanData.push_back(std::move(entry.scanData));
+        allAccelData.push_back(entry.accel_data);
+        allEulerData.push_back(entry.euler_data);
+        allCameraImage.push_back(entry.image);
+    }
 
-        bno055_euler_float_t euler_data;
-        file.read(reinterpret_cast<char*>(&euler_data), sizeof(bno055_euler_float_t));
+    return true;
+}
 
-        // Read image data
-        size_t imgSize = 0;
-        file.read(reinterpret_cast<char*>(&imgSize), sizeof(imgSize));
-        if (!file)
-            break;
+LogWriter::LogWriter(size_t capacity) : ring(capacity > 0 ? capacity : 1) {}
 
-        std::vector<uchar> buffer(imgSize);
-        file.read(reinterpret_cast<char*>(buffer.data()), imgSize);
-        if (!file)
-            break;
+LogWriter::~LogWriter() {
+    close();
+}
 
-        cv::Mat image = cv::imdecode(buffer, cv::IMREAD_UNCHANGED);
-        if (image.empty()) {
-            std::cerr << "Failed to decode image from file." << std::endl;
+bool LogWriter::open(const std::string& filePath, const LogImageOptions& imageOptions) {
+    close();
+
+    if (!createDirectoryIfNeeded(filePath)) {
+        std::cerr << "Failed to create directory for saving log data." << std::endl;
+        return false;
+    }
+
+    file.open(filePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for saving log data: " << filePath << std::endl;
+        return false;
+    }
+
+    writeLogFileHeader(file);
+    writeOffset = sizeof(LogFileHeader);
+    index.clear();
+    encoder = LogImageEncoder(imageOptions);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        head = tail = count = 0;
+        running = true;
+    }
+    writerThread = std::thread(&LogWriter::writerLoop, this);
+    return true;
+}
+
+void LogWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    recordReady.notify_one();
+
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+    if (file.is_open()) {
+        writeLogIndex(file, writeOffset, index);
+        if (!file) {
+            std::cerr << "Failed to write log index, readers will rebuild it." << std::endl;
+        }
+        file.close();
+    }
+}
+
+bool LogWriter::enqueue(const std::vector<lidarController::NodeData>& scanData,
+                        const bno055_accel_float_t& accel_data,
+                        const bno055_euler_float_t& euler_data,
+                        const cv::Mat& image) {
+    size_t slot;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running || count == ring.size()) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
             return false;
         }
+        // Reserve the slot, the writer thread skips it until it is marked ready
+        slot = head;
+        head = (head + 1) % ring.size();
+        ++count;
+    }
 
-        // Store the loaded data
-        allScanData.push_back(std::move(scanData));
-        allAccelData.push_back(accel_data);
-        allEulerData.push_back(euler_data);
-        allCameraImage.push_back(image);
+    // Nobody else touches a reserved slot, so fill it outside the lock.
+    // assign/copyTo reuse the slot's storage once it has seen a record of this size.
+    LogRecord& record = ring[slot];
+    record.timestampUs = steadyTimestampUs();
+    record.scanData.assign(scanData.begin(), scanData.end());
+    record.accel_data = accel_data;
+    record.euler_data = euler_data;
+    image.copyTo(record.image);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        record.ready = true;
+        queued.fetch_add(1, std::memory_order_relaxed);
+    }
+    recordReady.notify_one();
+    return true;
+}
+
+void LogWriter::writerLoop() {
+    while (true) {
+        size_t slot;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (count == 0) {
+                // Nothing pending, push what we have to disk before sleeping
+                lock.unlock();
+                file.flush();
+                lock.lock();
+            }
+            // Reserved slots keep count above 0, so close() waits for enqueue() calls still filling one
+            recordReady.wait(lock, [this] { return (count > 0 && ring[tail].ready) || (count == 0 && !running); });
+            if (count == 0) break;  // Stopped and drained
+            slot = tail;
+        }
+
+        const LogRecord& record = ring[slot];
+        uint64_t recordSize = writeLogRecord(file, writeOffset, record.timestampUs, record.scanData, record.accel_data, record.euler_data, record.image, encoder, encodeBuffer);
+        if (file) {
+            index.push_back({writeOffset, record.timestampUs});
+            writeOffset += recordSize;
+            written.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            std::cerr << "Failed to save log data to file." << std::endl;
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            file.clear();
+            writeOffset = static_cast<uint64_t>(file.tellp());
+            encoder.reset();  // The last keyframe may not have reached the file
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ring[slot].ready = false;
+            tail = (tail + 1) % ring.size();
+            --count;
+        }
+    }
+
+    file.flush();
+}
+
+LogReader::~LogReader() {
+    close();
+}
+
+bool LogReader::open(const std::string& filePath) {
+    close();
+
+    file.open(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for loading log data: " << filePath << std::endl;
+        return false;
+    }
+
+    std::error_code error;
+    fileSize = std::filesystem::file_size(filePath, error);
+    if (error) {
+        std::cerr << "Failed to get size of log file: " << filePath << std::endl;
+        close();
+        return false;
+    }
+
+    LogFileHeader header{};
+    if (fileSize >= sizeof(header)) {
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    }
+
+    if (fileSize >= sizeof(header) && isLogFileHeader(header)) {
+        if (header.version > LOG_FORMAT_VERSION || header.headerSize < sizeof(LogFileHeader)) {
+            std::cerr << "Unsupported log format version " << header.version << ": " << filePath << std::endl;
+            close();
+            return false;
+        }
+        formatVersion = header.version;
+
+        if (!loadFooterIndex()) {
+            scanRecords(header.headerSize);
+        }
+    } else {
+        formatVersion = 0;
+        scanLegacyRecords();
+    }
+
+    return true;
+}
+
+void LogReader::close() {
+    if (file.is_open()) {
+        file.close();
+    }
+    file.clear();
+    fileSize = 0;
+    formatVersion = 0;
+    index.clear();
+    cachedKeyframe.release();
+}
+
+size_t LogReader::findRecord(int64_t timestampUs) const {
+    auto it = std::lower_bound(index.begin(), index.end(), timestampUs,
+                               [](const LogIndexEntry& entry, int64_t time) { return entry.timestampUs < time; });
+    return static_cast<size_t>(it - index.begin());
+}
+
+bool LogReader::isLogRecordInFile(const LogRecordHeader& header, uint64_t offset) const {
+    // The sizes come straight from the file, check them before they size any buffer
+    return header.magic == LOG_RECORD_MAGIC && offset <= fileSize && header.imageSize <= fileSize
+        && offset + logRecordSize(header) <= fileSize;
+}
+
+bool LogReader::readRecord(size_t recordIndex, LogEntry& entry, bool decodeImage) {
+    if (recordIndex >= index.size()) {
+        return false;
+    }
+
+    file.clear();
+    file.seekg(index[recordIndex].offset);
+
+    if (formatVersion == 0) {
+        return readLegacyRecord(entry, decodeImage);
+    }
+
+    LogRecordHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || !isLogRecordInFile(header, index[recordIndex].offset)) {
+        std::cerr << "Corrupt log record " << recordIndex << "." << std::endl;
+        return false;
+    }
+
+    entry.timestampUs = header.timestampUs;
+    entry.accel_data = header.accel;
+    entry.euler_data = header.euler;
+
+    entry.scanData.resize(header.scanCount);
+    file.read(reinterpret_cast<char*>(entry.scanData.data()), header.scanCount * sizeof(lidarController::NodeData));
+
+    if (!decodeImage) {
+        entry.image.release();
+        return static_cast<bool>(file);
+    }
+
+    imageBuffer.resize(header.imageSize);
+    file.read(reinterpret_cast<char*>(imageBuffer.data()), header.imageSize);
+    if (!file) {
+        return false;
+    }
+
+    auto keyframeLoader = [this](uint64_t offset, cv::Mat& keyframe) { return loadKeyframe(offset, keyframe); };
+    if (!decodeLogImage(header, imageBuffer.data(), entry.image, keyframeLoader)) {
+        std::cerr << "Failed to decode image from file." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool LogReader::readLegacyRecord(LogEntry& entry, bool decodeImage) {
+    entry.timestampUs = 0;  // Legacy records have no timestamps
+
+    size_t dataSize = 0;
+    file.read(reinterpret_cast<char*>(&dataSize), sizeof(dataSize));
+    entry.scanData.resize(dataSize);
+    file.read(reinterpret_cast<char*>(entry.scanData.data()), dataSize * sizeof(lidarController::NodeData));
+
+    file.read(reinterpret_cast<char*>(&entry.accel_data), sizeof(bno055_accel_float_t));
+    file.read(reinterpret_cast<char*>(&entry.euler_data), sizeof(bno055_euler_float_t));
+
+    if (!decodeImage) {
+        entry.image.release();
+        return static_cast<bool>(file);
+    }
+
+    size_t imgSize = 0;
+    file.read(reinterpret_cast<char*>(&imgSize), sizeof(imgSize));
+    imageBuffer.resize(imgSize);
+    file.read(reinterpret_cast<char*>(imageBuffer.data()), imgSize);
+    if (!file) {
+        return false;
+    }
+
+    LogRecordHeader legacyHeader{};
+    legacyHeader.imageEncoding = static_cast<uint32_t>(LogImageEncoding::PNG);
+    legacyHeader.imageSize = imgSize;
+    if (!decodeLogImage(legacyHeader, imageBuffer.data(), entry.image)) {
+        std::cerr << "Failed to decode image from file." << std::endl;
+        return false;
     }
 
     return true;
 }
 
+bool LogReader::loadKeyframe(uint64_t offset, cv::Mat& keyframe) {
+    if (offset == cachedKeyframeOffset && !cachedKeyframe.empty()) {
+        keyframe = cachedKeyframe;
+        return true;
+    }
+
+    LogRecordHeader header{};
+    file.seekg(offset);
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || !isLogRecordInFile(header, offset) || header.imageEncoding == static_cast<uint32_t>(LogImageEncoding::DELTA)) {
+        return false;
+    }
+
+    keyframeBuffer.resize(header.imageSize);
+    file.seekg(header.scanCount * sizeof(lidarController::NodeData), std::ios::cur);
+    file.read(reinterpret_cast<char*>(keyframeBuffer.data()), header.imageSize);
+    if (!file || !decodeLogImage(header, keyframeBuffer.data(), cachedKeyframe)) {
+        cachedKeyframe.release();
+        return false;
+    }
+
+    cachedKeyframeOffset = offset;
+    keyframe = cachedKeyframe;
+    return true;
+}
+
+bool LogReader::loadFooterIndex() {
+    if (fileSize < sizeof(LogFileHeader) + sizeof(LogIndexHeader) + sizeof(LogFileTrailer)) {
+        return false;
+    }
+
+    LogFileTrailer trailer{};
+    file.seekg(fileSize - sizeof(trailer));
+    file.read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+    if (!file || trailer.magic != LOG_TRAILER_MAGIC) {
+        file.clear();
+        return false;
+    }
+
+    // The index must end exactly at the trailer, otherwise records were appended after it
+    uint64_t indexSize = sizeof(LogIndexHeader) + trailer.recordCount * sizeof(LogIndexEntry);
+    if (trailer.indexOffset + indexSize + sizeof(trailer) != fileSize) {
+        return false;
+    }
+
+    LogIndexHeader indexHeader{};
+    file.seekg(trailer.indexOffset);
+    file.read(reinterpret_cast<char*>(&indexHeader), sizeof(indexHeader));
+    if (!file || indexHeader.magic != LOG_INDEX_MAGIC || indexHeader.recordCount != trailer.recordCount) {
+        file.clear();
+        return false;
+    }
+
+    index.resize(trailer.recordCount);
+    file.read(reinterpret_cast<char*>(index.data()), index.size() * sizeof(LogIndexEntry));
+    if (!file) {
+        file.clear();
+        index.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void LogReader::scanRecords(uint64_t offset) {
+    index.clear();
+
+    while (offset + sizeof(uint32_t) <= fileSize) {
+        uint32_t magic = 0;
+        file.seekg(offset);
+        file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        if (!file) break;
+
+        if (magic == LOG_RECORD_MAGIC) {
+            LogRecordHeader header{};
+            file.seekg(offset);
+            file.read(reinterpret_cast<char*>(&header), sizeof(header));
+            uint64_t recordSize = logRecordSize(header);
+            if (!file || offset + recordSize > fileSize) break;  // Truncated last record
+
+            index.push_back({offset, header.timestampUs});
+            offset += recordSize;
+        } else if (magic == LOG_INDEX_MAGIC) {
+            // Index of an earlier session, more records may follow it
+            LogIndexHeader indexHeader{};
+            file.seekg(offset);
+            file.read(reinterpret_cast<char*>(&indexHeader), sizeof(indexHeader));
+            if (!file) break;
+            offset += sizeof(LogIndexHeader) + indexHeader.recordCount * sizeof(LogIndexEntry) + sizeof(LogFileTrailer);
+        } else {
+            std::cerr << "Unexpected data at log offset " << offset << ", ignoring the rest of the file." << std::endl;
+            break;
+        }
+    }
+
+    file.clear();
+}
+
+void LogReader::scanLegacyRecords() {
+    index.clear();
+
+    uint64_t offset = 0;
+    while (offset + sizeof(size_t) <= fileSize) {
+        size_t dataSize = 0;
+        file.seekg(offset);
+        file.read(reinterpret_cast<char*>(&dataSize), sizeof(dataSize));
+        if (!file || dataSize > (fileSize - offset) / sizeof(lidarController::NodeData)) break;
+
+        uint64_t imageSizeOffset = offset + sizeof(size_t) + dataSize * sizeof(lidarController::NodeData)
+                                 + sizeof(bno055_accel_float_t) + sizeof(bno055_euler_float_t);
+        size_t imgSize = 0;
+        file.seekg(imageSizeOffset);
+        file.read(reinterpret_cast<char*>(&imgSize), sizeof(imgSize));
+        if (!file) break;
+
+        uint64_t nextOffset = imageSizeOffset + sizeof(size_t) + imgSize;
+        if (imgSize > fileSize || nextOffset > fileSize) break;  // Truncated last record
+
+        index.push_back({offset, 0});
+        offset = nextOffset;
+    }
+
+    file.clear();
+}
 
 }  // namespace DataSaver
@@ -3,28 +3,245 @@
 
 #include <string>
 #include <vector>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <opencv2/opencv.hpp>
 
 #include "lidar_struct.h"
 #include "bno055_struct.h"
+#include "logFormat.h"
 
 namespace DataSaver {
 
 bool saveData(const std::string& filePath, const uint8_t calibData[22], bool append = true);
 bool loadData(const std::string& filePath, uint8_t calibData[22]);
 
+// Appends one record to a version 1 log container, creating the file header if needed.
+// The index is not updated, readers rebuild it; prefer LogWriter for whole runs.
 bool saveLogData(const std::string& filePath, 
                  const std::vector<lidarController::NodeData>& scanData, 
                  const bno055_accel_float_t& accel_data, 
                  const bno055_euler_float_t& euler_data, 
                  const cv::Mat& image, 
                  bool append = true);
+// Loads and decodes every record of a log file (version 1 or legacy) into memory.
 bool loadLogData(const std::string& filePath, 
                  std::vector<std::vector<lidarController::NodeData>>& allScanData, 
                  std::vector<bno055_accel_float_t>& allAccelData, 
                  std::vector<bno055_euler_float_t>& allEulerData, 
                  std::vector<cv::Mat>& allImages);
 
+/**
+ * @brief How LogWriter stores camera images.
+ */
+struct LogImageOptions {
+    LogImageEncoding encoding = LogImageEncoding::PNG;
+    int jpegQuality = 90;       ///< JPEG only, 0-100.
+    int pngCompression = 1;     ///< PNG and DELTA, 0-9. Higher is smaller and slower.
+    int keyframeInterval = 30;  ///< DELTA only, frames between full PNG keyframes.
+};
+
+/**
+ * @brief Encodes record images according to LogImageOptions.
+ *
+ * For DELTA the encoder remembers the last keyframe, so one encoder must see every
+ * record of a file in order.
+ */
+class LogImageEncoder {
+public:
+    explicit LogImageEncoder(const LogImageOptions& options = LogImageOptions());
+
+    /**
+     * @brief Encodes an image for the record written at recordOffset.
+     * Fills the image fields of the header. On failure the record is stored without an image.
+     * @return true on success.
+     */
+    bool encode(const cv::Mat& image, uint64_t recordOffset, LogRecordHeader& header, std::vector<uchar>& buffer);
+
+    /**
+     * @brief Forces the next DELTA frame to be a keyframe.
+     */
+    void reset();
+
+private:
+    LogImageOptions options;
+    std::vector<int> params;
+
+    cv::Mat keyframe;
+    uint64_t keyframeOffset = 0;
+    int framesSinceKeyframe = 0;
+    cv::Mat deltaImage;
+    std::vector<uchar> deltaBuffer;
+};
+
+// Decodes the image of the record at the given file offset, used to resolve DELTA frames
+using LogKeyframeLoader = std::function<bool(uint64_t offset, cv::Mat& keyframe)>;
+
+// Decodes the image bytes of a record according to its header
+bool decodeLogImage(const LogRecordHeader& header, const uchar* data, cv::Mat& image, const LogKeyframeLoader& loadKeyframe = nullptr);
+
+/**
+ * @brief Background writer for log records in the saveLogData format.
+ *
+ * enqueue() copies the record into a preallocated slot of a bounded ring and returns
+ * immediately. A dedicated thread keeps the file open, encodes the images (see
+ * LogImageOptions) and writes the records in order. close() appends the frame index
+ * so readers can seek. When the ring is full the new record is dropped (never blocks),
+ * so logging cannot add latency to the control loop.
+ *
+ * enqueue() may be called from several threads. Records are written in the order their
+ * slots were reserved, and close() writes every record whose enqueue() had started.
+ */
+class LogWriter {
+public:
+    /**
+     * @param capacity Number of records that can be pending at once.
+     */
+    explicit LogWriter(size_t capacity = 16);
+    ~LogWriter();
+
+    LogWriter(const LogWriter&) = delete;
+    LogWriter& operator=(const LogWriter&) = delete;
+
+    /**
+     * @brief Creates (or truncates) the log file and starts the writer thread.
+     * @param imageOptions Encoding used for the camera images of this log.
+     * @return true if the file was opened.
+     */
+    bool open(const std::string& filePath, const LogImageOptions& imageOptions = LogImageOptions());
+
+    /**
+     * @brief Writes every pending record and the frame index, stops the writer thread and closes the file.
+     */
+    void close();
+
+    /**
+     * @brief Queues a record without blocking. The record is timestamped here, at capture time.
+     * @return true if queued, false if it was dropped because the ring is full or the writer is not open.
+     */
+    bool enqueue(const std::vector<lidarController::NodeData>& scanData,
+                 const bno055_accel_float_t& accel_data,
+                 const bno055_euler_float_t& euler_data,
+                 const cv::Mat& image);
+
+    uint64_t queuedCount() const { return queued.load(std::memory_order_relaxed); }    ///< Records accepted by enqueue().
+    uint64_t writtenCount() const { return written.load(std::memory_order_relaxed); }  ///< Records written to the file.
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }  ///< Records rejected by enqueue() or lost to write errors.
+
+private:
+    struct LogRecord {
+        int64_t timestampUs;
+        std::vector<lidarController::NodeData> scanData;
+        bno055_accel_float_t accel_data;
+        bno055_euler_float_t euler_data;
+        cv::Mat image;
+        bool ready = false;  ///< Set once enqueue() has filled the slot.
+    };
+
+    void writerLoop();
+
+    std::vector<LogRecord> ring;
+    size_t head = 0;   ///< Next slot enqueue() reserves.
+    size_t tail = 0;   ///< Next slot the writer thread writes.
+    size_t count = 0;  ///< Reserved slots, including ones still being filled and the one being written.
+    bool running = false;
+
+    std::mutex mutex;
+    std::condition_variable recordReady;
+    std::thread writerThread;
+    std::ofstream file;
+    LogImageEncoder encoder;          ///< Only touched by the writer thread.
+    std::vector<uchar> encodeBuffer;  ///< Reused image buffer, only touched by the writer thread.
+    std::vector<LogIndexEntry> index; ///< Frame index written on close(), only touched by the writer thread.
+    uint64_t writeOffset = 0;         ///< File offset of the next record.
+
+    std::atomic<uint64_t> queued{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+};
+
+/**
+ * @brief One decoded log record.
+ */
+struct LogEntry {
+    int64_t timestampUs = 0;  ///< Steady clock capture time, 0 for legacy files.
+    std::vector<lidarController::NodeData> scanData;
+    bno055_accel_float_t accel_data;
+    bno055_euler_float_t euler_data;
+    cv::Mat image;
+};
+
+/**
+ * @brief Random access reader for log files.
+ *
+ * open() only reads the frame index (from the footer, or by walking the record headers
+ * when the file was not closed cleanly), so any record can then be read in O(1) and
+ * images are only decoded for the records that are actually read.
+ * Legacy files without a container header are indexed by walking their size prefixes.
+ */
+class LogReader {
+public:
+    LogReader() = default;
+    ~LogReader();
+
+    LogReader(const LogReader&) = delete;
+    LogReader& operator=(const LogReader&) = delete;
+
+    /**
+     * @brief Opens a log file and loads or rebuilds its frame index.
+     * @return true if the file could be opened.
+     */
+    bool open(const std::string& filePath);
+
+    void close();
+
+    size_t recordCount() const { return index.size(); }
+
+    /**
+     * @return Container version of the open file, 0 for the legacy format.
+     */
+    uint32_t version() const { return formatVersion; }
+
+    int64_t recordTimestampUs(size_t recordIndex) const { return index[recordIndex].timestampUs; }
+
+    const std::vector<LogIndexEntry>& recordIndex() const { return index; }
+
+    /**
+     * @brief Finds the first record captured at or after the given time.
+     * @return The record index, or recordCount() if there is none.
+     */
+    size_t findRecord(int64_t timestampUs) const;
+
+    /**
+     * @brief Reads one record. The entry's buffers are reused between calls.
+     * @param decodeImage Skip reading the camera image when false.
+     * @return true on success.
+     */
+    bool readRecord(size_t recordIndex, LogEntry& entry, bool decodeImage = true);
+
+private:
+    bool loadFooterIndex();
+    void scanRecords(uint64_t offset);
+    void scanLegacyRecords();
+    bool readLegacyRecord(LogEntry& entry, bool decodeImage);
+    bool loadKeyframe(uint64_t offset, cv::Mat& keyframe);
+    bool isLogRecordInFile(const LogRecordHeader& header, uint64_t offset) const;
+
+    std::ifstream file;
+    uint64_t fileSize = 0;
+    uint32_t formatVersion = 0;
+    std::vector<LogIndexEntry> index;
+    std::vector<uchar> imageBuffer;
+
+    std::vector<uchar> keyframeBuffer;
+    uint64_t cachedKeyframeOffset = 0;
+    cv::Mat cachedKeyframe;  ///< Last keyframe used by a DELTA record.
+};
+
 }  // namespace DataSaver
 
 #endif  // DATASAVER_H
@@ -1,8 +1,12 @@
 #include "i2c_master.h"
 
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <sys/ioctl.h>
 #include <unistd.h>
 #include <wiringPiI2C.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdio>
 #include <cstring>
@@ -61,6 +65,23 @@ void i2c_master_read_logs(int fd, uint8_t *logs, size_t len) {
     }
 }
 
+uint16_t i2c_master_read_logs_count(int fd) {
+    uint8_t raw_count[i2c_slave_mem_addr::LOG_COUNT_SIZE] = {0};
+    i2c_master_read_data(fd, i2c_slave_mem_addr::LOG_COUNT_ADDR, raw_count, sizeof(raw_count));
+
+    uint16_t logs_count;
+    std::memcpy(&logs_count, raw_count, sizeof(logs_count));
+    return logs_count;
+}
+
+size_t i2c_master_read_new_logs(int fd, uint8_t *logs, size_t len) {
+    size_t count = std::min<size_t>(i2c_master_read_logs_count(fd), len);
+    if (count > 0) {
+        i2c_master_read_logs(fd, logs, count);
+    }
+    return count;
+}
+
 void i2c_master_print_logs(uint8_t *logs, size_t len) {
     if (logs == NULL) {
         return;  // Handle null pointer gracefully
@@ -110,4 +131,87 @@ void i2c_master_read_bno055_accel_and_euler(int fd, bno055_accel_float_t *accel_
     std::memcpy(&euler_data->h, &raw_data[12], sizeof(float));
     std::memcpy(&euler_data->r, &raw_data[16], sizeof(float));
     std::memcpy(&euler_data->p, &raw_data[20], sizeof(float));
-}
\ No newline at end of file
+}
+static void parse_imu_sample(const uint8_t *raw_sample, imu_sample_t *sample) {
+    std::memcpy(&sample->sequence, raw_sample, i2c_slave_mem_addr::IMU_SAMPLE_SEQUENCE_SIZE);
+    raw_sample += i2c_slave_mem_addr::IMU_SAMPLE_SEQUENCE_SIZE;
+    std::memcpy(&sample->timestamp_us, raw_sample, i2c_slave_mem_addr::IMU_SAMPLE_TIMESTAMP_SIZE);
+    raw_sample += i2c_slave_mem_addr::IMU_SAMPLE_TIMESTAMP_SIZE;
+    std::memcpy(&sample->accel_data, raw_sample, i2c_slave_mem_addr::ACCEL_DATA_SIZE);
+    std::memcpy(&sample->euler_data, raw_sample + i2c_slave_mem_addr::ACCEL_DATA_SIZE, i2c_slave_mem_addr::EULER_ANGLE_SIZE);
+}
+
+bool i2c_master_exchange(int fd, uint8_t slave_address, float motor_percent, float steering_percent, i2c_exchange_t *exchange) {
+    uint8_t write_buffer[1 + i2c_slave_mem_addr::EXCHANGE_WRITE_SIZE];
+    write_buffer[0] = i2c_slave_mem_addr::EXCHANGE_ADDR;
+    std::memcpy(&write_buffer[1], &motor_percent, sizeof(float));
+    std::memcpy(&write_buffer[1 + sizeof(float)], &steering_percent, sizeof(float));
+
+    uint8_t read_buffer[i2c_slave_mem_addr::EXCHANGE_READ_SIZE];
+
+    i2c_msg messages[2];
+    messages[0].addr = slave_address;
+    messages[0].flags = 0;
+    messages[0].len = sizeof(write_buffer);
+    messages[0].buf = write_buffer;
+    messages[1].addr = slave_address;
+    messages[1].flags = I2C_M_RD;
+    messages[1].len = sizeof(read_buffer);
+    messages[1].buf = read_buffer;
+
+    i2c_rdwr_ioctl_data transfer;
+    transfer.msgs = messages;
+    transfer.nmsgs = 2;
+    if (ioctl(fd, I2C_RDWR, &transfer) == -1) {
+        perror("Failed to exchange data");
+        return false;
+    }
+
+    exchange->status = read_buffer[i2c_slave_mem_addr::EXCHANGE_STATUS_OFFSET];
+    const uint8_t *info = &read_buffer[i2c_slave_mem_addr::EXCHANGE_BNO055_INFO_OFFSET];
+    std::memcpy(&exchange->accel_data, info, i2c_slave_mem_addr::ACCEL_DATA_SIZE);
+    std::memcpy(&exchange->euler_data, info + i2c_slave_mem_addr::ACCEL_DATA_SIZE, i2c_slave_mem_addr::EULER_ANGLE_SIZE);
+    std::memcpy(&exchange->logs_count, &read_buffer[i2c_slave_mem_addr::EXCHANGE_LOG_COUNT_OFFSET], i2c_slave_mem_addr::LOG_COUNT_SIZE);
+    exchange->imu_sample_count = read_buffer[i2c_slave_mem_addr::EXCHANGE_IMU_SAMPLE_COUNT_OFFSET];
+    std::memcpy(&exchange->time_us, &read_buffer[i2c_slave_mem_addr::EXCHANGE_TIME_US_OFFSET], i2c_slave_mem_addr::TIME_US_SIZE);
+
+    exchange->imu_samples_received = std::min<size_t>(exchange->imu_sample_count, i2c_slave_mem_addr::EXCHANGE_IMU_SAMPLES_COUNT);
+    for (size_t i = 0; i < exchange->imu_samples_received; i++) {
+        parse_imu_sample(&read_buffer[i2c_slave_mem_addr::EXCHANGE_IMU_SAMPLES_OFFSET + i * i2c_slave_mem_addr::IMU_SAMPLE_SIZE], &exchange->imu_samples[i]);
+    }
+    return true;
+}
+
+uint8_t i2c_master_read_imu_sample_count(int fd) {
+    uint8_t count = 0;
+    i2c_master_read_data(fd, i2c_slave_mem_addr::IMU_SAMPLE_COUNT_ADDR, &count, i2c_slave_mem_addr::IMU_SAMPLE_COUNT_SIZE);
+    return count;
+}
+
+size_t i2c_master_read_imu_samples(int fd, imu_sample_t *samples, size_t count) {
+    count = std::min(count, i2c_slave_mem_addr::IMU_SAMPLES_BUFFER_SIZE);
+    if (count == 0) {
+        return 0;
+    }
+
+    uint8_t raw_samples[i2c_slave_mem_addr::IMU_SAMPLES_BUFFER_SIZE * i2c_slave_mem_addr::IMU_SAMPLE_SIZE];
+    uint8_t reg = i2c_slave_mem_addr::IMU_SAMPLES_ADDR;
+    if (write(fd, &reg, 1) == -1) {
+        perror("Failed to set IMU samples address");
+        return 0;
+    }
+    if (read(fd, raw_samples, count * i2c_slave_mem_addr::IMU_SAMPLE_SIZE) == -1) {
+        perror("Failed to read IMU samples");
+        return 0;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        parse_imu_sample(&raw_samples[i * i2c_slave_mem_addr::IMU_SAMPLE_SIZE], &samples[i]);
+    }
+    return count;
+}
+
+size_t i2c_master_drain_imu_samples(int fd, imu_sample_t *samples, size_t max_samples) {
+    size_t count = std::min<size_t>(i2c_master_read_imu_sample_count(fd), max_samples);
+    return i2c_master_read_imu_samples(fd, samples, count);
+}
@@ -29,16 +29,53 @@ namespace i2c_slave_mem_addr {
   const size_t LOG_SIZE = 1;
   const size_t LOGS_BUFFER_SIZE = 256;
 
+  // Number of unread log bytes (uint16_t), captured when the master selects the register.
+  // Reading that many bytes from LOG_ADDR fetches exactly the new logs.
+  const size_t LOG_COUNT_SIZE = sizeof(uint16_t);
+
+  // IMU samples are published into a ring at a fixed rate. A sample is its sequence number (uint32_t),
+  // the time_us_64() it was read at (uint64_t), then the accel and euler data as in BNO055 info.
+  const size_t IMU_SAMPLE_SEQUENCE_SIZE = sizeof(uint32_t);
+  const size_t IMU_SAMPLE_TIMESTAMP_SIZE = sizeof(uint64_t);
+  const size_t IMU_SAMPLE_SIZE = (IMU_SAMPLE_SEQUENCE_SIZE + IMU_SAMPLE_TIMESTAMP_SIZE + BNO055_INFO_SIZE);
+  const size_t IMU_SAMPLES_BUFFER_SIZE = 16;  // Samples, the oldest is dropped when the ring is full
+  const size_t IMU_SAMPLES_SIZE = 1;
+
+  // Number of unread IMU samples (uint8_t) and the Pico time in us (uint64_t), both captured when the
+  // master selects the register. Reading that many samples from IMU_SAMPLES_ADDR fetches exactly the new ones.
+  const size_t IMU_SAMPLE_COUNT_SIZE = sizeof(uint8_t);
+  const size_t TIME_US_SIZE = sizeof(uint64_t);
+
+  // Virtual register for the per-tick exchange: the master writes the movement info and, in the same
+  // transaction after a repeated start, reads status, BNO055 info, the unread log byte count, the unread
+  // IMU sample count, the Pico time and the oldest unread IMU samples (up to EXCHANGE_IMU_SAMPLES_COUNT,
+  // padded with 0xFF). Samples beyond that stay in the ring for the next exchange.
+  const size_t EXCHANGE_SIZE = 1;
+  const size_t EXCHANGE_WRITE_SIZE = MOVEMENT_INFO_SIZE;
+  const size_t EXCHANGE_STATUS_OFFSET = 0;
+  const size_t EXCHANGE_BNO055_INFO_OFFSET = (EXCHANGE_STATUS_OFFSET + STATUS_SIZE);
+  const size_t EXCHANGE_LOG_COUNT_OFFSET = (EXCHANGE_BNO055_INFO_OFFSET + BNO055_INFO_SIZE);
+  const size_t EXCHANGE_IMU_SAMPLE_COUNT_OFFSET = (EXCHANGE_LOG_COUNT_OFFSET + LOG_COUNT_SIZE);
+  const size_t EXCHANGE_TIME_US_OFFSET = (EXCHANGE_IMU_SAMPLE_COUNT_OFFSET + IMU_SAMPLE_COUNT_SIZE);
+  const size_t EXCHANGE_IMU_SAMPLES_COUNT = 3;  // Samples come at twice the control rate, one spare to catch up
+  const size_t EXCHANGE_IMU_SAMPLES_OFFSET = (EXCHANGE_TIME_US_OFFSET + TIME_US_SIZE);
+  const size_t EXCHANGE_READ_SIZE = (EXCHANGE_IMU_SAMPLES_OFFSET + EXCHANGE_IMU_SAMPLES_COUNT * IMU_SAMPLE_SIZE);
+
   const size_t COMMAND_ADDR = 0;
   const size_t STATUS_ADDR = (COMMAND_ADDR + COMMAND_SIZE);
   const size_t BNO055_CALIB_ADDR = (STATUS_ADDR + STATUS_SIZE);
   const size_t BNO055_INFO_ADDR = (BNO055_CALIB_ADDR + BNO055_CALIB_SIZE);
   const size_t MOVEMENT_INFO_ADDR = (BNO055_INFO_ADDR + BNO055_INFO_SIZE);
   const size_t LOG_ADDR = (MOVEMENT_INFO_ADDR + MOVEMENT_INFO_SIZE);
+  const size_t EXCHANGE_ADDR = (LOG_ADDR + LOG_SIZE);
+  const size_t LOG_COUNT_ADDR = (EXCHANGE_ADDR + EXCHANGE_SIZE);
+  const size_t IMU_SAMPLES_ADDR = (LOG_COUNT_ADDR + LOG_COUNT_SIZE);
+  const size_t IMU_SAMPLE_COUNT_ADDR = (IMU_SAMPLES_ADDR + IMU_SAMPLES_SIZE);
+  const size_t TIME_US_ADDR = (IMU_SAMPLE_COUNT_ADDR + IMU_SAMPLE_COUNT_SIZE);
 
 
   // Check if total memory allocation fits within the available memory
-  static_assert(LOG_ADDR + LOG_SIZE <= MEM_SIZE, "Memory allocation exceeds buffer size");
+  static_assert(TIME_US_ADDR + TIME_US_SIZE <= MEM_SIZE, "Memory allocation exceeds buffer size");
 }
 
 enum Command : uint8_t {
@@ -49,6 +86,30 @@ enum Command : uint8_t {
   SKIP_CALIB = 0x04
 };
 
+/**
+ * @brief One IMU sample from the slave's sample ring.
+ */
+struct imu_sample_t {
+  uint32_t sequence;  // Consecutive per sample, a gap means the ring overflowed
+  uint64_t timestamp_us;  // Pico time_us_64() when the data was read
+  bno055_accel_float_t accel_data;
+  bno055_euler_float_t euler_data;
+};
+
+/**
+ * @brief What the slave returns from one i2c_master_exchange.
+ */
+struct i2c_exchange_t {
+  uint8_t status;
+  bno055_accel_float_t accel_data;
+  bno055_euler_float_t euler_data;
+  uint16_t logs_count;  // Unread log bytes, fetch them with i2c_master_read_logs
+  uint8_t imu_sample_count;  // Unread IMU samples when the exchange started, including the ones below
+  uint64_t time_us;  // Pico time_us_64() when the exchange started
+  imu_sample_t imu_samples[i2c_slave_mem_addr::EXCHANGE_IMU_SAMPLES_COUNT];  // Oldest unread samples first
+  uint8_t imu_samples_received;  // Valid entries of imu_samples, the rest stay on the slave
+};
+
 
 /**
  * @brief Initializes the I2C master communication with the specified slave address.
@@ -103,6 +164,26 @@ void i2c_master_read_logs(int fd, uint8_t *logs);
  */
 void i2c_master_read_logs(int fd, uint8_t *logs, size_t len);
 
+/**
+ * @brief Reads the number of log bytes the I2C slave has not sent yet.
+ *
+ * @param fd File descriptor of the I2C device.
+ * @return The number of unread log bytes.
+ */
+uint16_t i2c_master_read_logs_count(int fd);
+
+/**
+ * @brief Reads only the log bytes that are new since the last log read.
+ *
+ * Costs a 2 byte read when there are no new logs, instead of a full LOGS_BUFFER_SIZE read.
+ *
+ * @param fd File descriptor of the I2C device.
+ * @param logs Pointer to the buffer to store the logs.
+ * @param len Size of the log buffer, newer bytes beyond it stay on the slave for the next read.
+ * @return Number of log bytes read into logs.
+ */
+size_t i2c_master_read_new_logs(int fd, uint8_t *logs, size_t len);
+
 /**
  * @brief Prints the logs in a readable format.
  *
@@ -164,5 +245,49 @@ void i2c_master_read_movement_info(int fd, uint8_t *movement_info);
  */
 void i2c_master_read_bno055_accel_and_euler(int fd, bno055_accel_float_t *accel_data, bno055_euler_float_t *euler_data);
 
+/**
+ * @brief Sends the movement info and reads status, BNO055 info, the unread log and IMU sample counts,
+ *        the Pico time and the oldest unread IMU samples in one I2C transaction.
+ *
+ * Uses a single I2C_RDWR ioctl (write, repeated start, read) on the EXCHANGE_ADDR register instead of
+ * one register write plus read per item.
+ *
+ * @param fd File descriptor of the I2C device.
+ * @param slave_address The 7-bit address of the I2C slave device.
+ * @param motor_percent Motor percentage to send.
+ * @param steering_percent Steering percentage to send.
+ * @param exchange Pointer to the structure where the returned data will be stored.
+ * @return True on success, false if the transfer failed.
+ */
+bool i2c_master_exchange(int fd, uint8_t slave_address, float motor_percent, float steering_percent, i2c_exchange_t *exchange);
+
+/**
+ * @brief Reads the number of IMU samples the I2C slave has not sent yet.
+ *
+ * @param fd File descriptor of the I2C device.
+ * @return The number of unread IMU samples.
+ */
+uint8_t i2c_master_read_imu_sample_count(int fd);
+
+/**
+ * @brief Reads the oldest unread IMU samples, the slave drops them once they are sent.
+ *
+ * @param fd File descriptor of the I2C device.
+ * @param samples Pointer to the array to store the samples, oldest first.
+ * @param count Number of samples to read, at most IMU_SAMPLES_BUFFER_SIZE.
+ * @return Number of samples read, 0 if the transfer failed.
+ */
+size_t i2c_master_read_imu_samples(int fd, imu_sample_t *samples, size_t count);
+
+/**
+ * @brief Reads all IMU samples published since the last read.
+ *
+ * @param fd File descriptor of the I2C device.
+ * @param samples Pointer to the array to store the samples, oldest first.
+ * @param max_samples Size of the samples array, newer samples beyond it stay on the slave for the next read.
+ * @return Number of samples read.
+ */
+size_t i2c_master_drain_imu_samples(int fd, imu_sample_t *samples, size_t max_samples);
+
 
 #endif // I2C_MASTER_H
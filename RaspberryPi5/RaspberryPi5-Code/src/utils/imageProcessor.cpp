@@ -1,23 +1,84 @@
 #include "imageProcessor.h"
 
-std::vector<cv::Point> getCoordinates(const cv::Mat &mask) {
-    std::vector<cv::Point> coordinates;
-    cv::findNonZero(mask, coordinates);
-    return coordinates;
+#include <algorithm>
+#include <opencv2/core/hal/intrin.hpp>
+
+#include "colorLookupTable.h"
+#include "trace.h"
+
+// Inclusive HSV bounds of one color range and the label bit it sets
+struct HsvRange {
+    uchar lower[3];
+    uchar upper[3];
+    uint8_t label;
+};
+
+const std::vector<ColorRange> &defaultColorRanges() {
+    static const std::vector<ColorRange> ranges = {
+        {lowerBlueLine, upperBlueLine, LABEL_BLUE},
+        {lowerOrangeLine, upperOrangeLine, LABEL_ORANGE},
+        {lowerRed1Light, upperRed1Light, LABEL_RED},
+        {lowerRed2Light, upperRed2Light, LABEL_RED},
+        {lowerGreen1Light, upperGreen1Light, LABEL_GREEN},
+        {lowerGreen2Light, upperGreen2Light, LABEL_GREEN},
+        {lowerPinkLight, upperPinkLight, LABEL_PINK},
+    };
+    return ranges;
 }
 
-int getAverageX(const std::vector<cv::Point> &coordinates) {
-    if (coordinates.empty()) return -1;
-    int sum = 0;
-    for (const auto &pt : coordinates) sum += pt.x;
-    return sum / coordinates.size();
+static std::vector<HsvRange> makeHsvRanges(const std::vector<ColorRange> &ranges) {
+    std::vector<HsvRange> hsvRanges;
+    for (const auto &range : ranges) {
+        HsvRange hsvRange;
+        for (int c = 0; c < 3; c++) {
+            hsvRange.lower[c] = cv::saturate_cast<uchar>(range.lower[c]);
+            hsvRange.upper[c] = cv::saturate_cast<uchar>(range.upper[c]);
+        }
+        hsvRange.label = range.label;
+        hsvRanges.push_back(hsvRange);
+    }
+    return hsvRanges;
 }
 
-int getAverageY(const std::vector<cv::Point> &coordinates) {
-    if (coordinates.empty()) return -1;
-    int sum = 0;
-    for (const auto &pt : coordinates) sum += pt.y;
-    return sum / coordinates.size();
+// Converted once so classifyColors matches inRange on the constants in imageProcessor.h
+static const std::vector<HsvRange> colorRanges = makeHsvRanges(defaultColorRanges());
+
+static void classifyHsvRow(const uchar *hsv, uchar *labels, int width) {
+    int x = 0;
+#if CV_SIMD128
+    // 16 pixels per step, NEON on the Pi and SSE on x86
+    for (; x <= width - 16; x += 16) {
+        cv::v_uint8x16 h, s, v;
+        cv::v_load_deinterleave(hsv + x * 3, h, s, v);
+        cv::v_uint8x16 result = cv::v_setzero_u8();
+        for (const auto &range : colorRanges) {
+            cv::v_uint8x16 match = (h >= cv::v_setall_u8(range.lower[0])) & (h <= cv::v_setall_u8(range.upper[0])) &
+                                   (s >= cv::v_setall_u8(range.lower[1])) & (s <= cv::v_setall_u8(range.upper[1])) &
+                                   (v >= cv::v_setall_u8(range.lower[2])) & (v <= cv::v_setall_u8(range.upper[2]));
+            result = result | (match & cv::v_setall_u8(range.label));
+        }
+        cv::v_store(labels + x, result);
+    }
+#endif
+    for (; x < width; x++) {
+        const uchar *pixel = hsv + x * 3;
+        uchar result = 0;
+        for (const auto &range : colorRanges) {
+            if (pixel[0] >= range.lower[0] && pixel[0] <= range.upper[0] &&
+                pixel[1] >= range.lower[1] && pixel[1] <= range.upper[1] &&
+                pixel[2] >= range.lower[2] && pixel[2] <= range.upper[2]) {
+                result |= range.label;
+            }
+        }
+        labels[x] = result;
+    }
+}
+
+MaskStatistics getMaskStatistics(const cv::Mat &mask) {
+    // One streaming pass, m00 is the pixel count and m10/m01 the coordinate sums
+    cv::Moments M = cv::moments(mask, true);
+    if (M.m00 == 0) return {0, -1, -1};
+    return {static_cast<int>(M.m00), static_cast<int>(M.m10 / M.m00), static_cast<int>(M.m01 / M.m00)};
 }
 
 std::tuple<cv::Point, double, cv::Point> getCentroidAndArea(const std::vector<cv::Point> &contour) {
@@ -29,19 +90,12 @@ std::tuple<cv::Point, double, cv::Point> getCentroidAndArea(const std::vector<cv
     return {centroid, area, lowestPoint};
 }
 
-ImageProcessingResult processImage(const cv::Mat &image) {
-    // Remove the top 40% of the image
-    int cropHeight = static_cast<int>(image.rows * CROP_PERCENT);
-    cv::Rect cropRegion(0, cropHeight, image.cols, image.rows - cropHeight);
-    cv::Mat croppedImage = image(cropRegion);
-
-    cv::Mat hsvImage;
-    cv::cvtColor(croppedImage, hsvImage, cv::COLOR_BGR2HSV);
-
+// Everything after classification, labels covers the image below cropHeight
+static ImageProcessingResult processLabels(const cv::Mat &labels, int cropHeight) {
     // Masks for blue and orange
     cv::Mat maskBlue, maskOrange;
-    cv::inRange(hsvImage, lowerBlueLine, upperBlueLine, maskBlue);
-    cv::inRange(hsvImage, lowerOrangeLine, upperOrangeLine, maskOrange);
+    cv::bitwise_and(labels, cv::Scalar(LABEL_BLUE), maskBlue);
+    cv::bitwise_and(labels, cv::Scalar(LABEL_ORANGE), maskOrange);
 
     std::vector<std::vector<cv::Point>> contoursBlue, contoursOrange;
     cv::findContours(maskBlue, contoursBlue, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
@@ -62,22 +116,18 @@ ImageProcessingResult processImage(const cv::Mat &image) {
         }
     }
 
-    std::vector<cv::Point> blueCoordinates = getCoordinates(filteredMaskBlue);
-    std::vector<cv::Point> orangeCoordinates = getCoordinates(filteredMaskOrange);
+    MaskStatistics blueStatistics = getMaskStatistics(filteredMaskBlue);
+    MaskStatistics orangeStatistics = getMaskStatistics(filteredMaskOrange);
 
-    int blueLineY = getAverageY(blueCoordinates);
-    int blueLineSize = blueCoordinates.size();
-    int orangeLineY = getAverageY(orangeCoordinates);
-    int orangeLineSize = orangeCoordinates.size();
+    int blueLineY = blueStatistics.averageY;
+    int blueLineSize = blueStatistics.count;
+    int orangeLineY = orangeStatistics.averageY;
+    int orangeLineSize = orangeStatistics.count;
 
-    // Masks for red and green
-    cv::Mat maskRed1, maskRed2, maskRed, maskGreen1, maskGreen2, maskGreen;
-    cv::inRange(hsvImage, lowerRed1Light, upperRed1Light, maskRed1);
-    cv::inRange(hsvImage, lowerRed2Light, upperRed2Light, maskRed2);
-    maskRed = maskRed1 | maskRed2;
-    cv::inRange(hsvImage, lowerGreen1Light, upperGreen1Light, maskGreen1);
-    cv::inRange(hsvImage, lowerGreen2Light, upperGreen2Light, maskGreen2);
-    maskGreen = maskGreen1 | maskGreen2;
+    // Masks for red and green, both ranges of each already share one label
+    cv::Mat maskRed, maskGreen;
+    cv::bitwise_and(labels, cv::Scalar(LABEL_RED), maskRed);
+    cv::bitwise_and(labels, cv::Scalar(LABEL_GREEN), maskGreen);
 
     std::vector<std::vector<cv::Point>> contoursRed, contoursGreen;
     cv::findContours(maskRed, contoursRed, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
@@ -100,12 +150,12 @@ ImageProcessingResult processImage(const cv::Mat &image) {
 
     // Mask for pink
     cv::Mat maskPink;
-    cv::inRange(hsvImage, lowerPinkLight, upperPinkLight, maskPink);
+    cv::bitwise_and(labels, cv::Scalar(LABEL_PINK), maskPink);
 
-    std::vector<cv::Point> pinkCoordinates = getCoordinates(maskPink);
-    int pinkX = getAverageX(pinkCoordinates);
-    int pinkY = getAverageY(pinkCoordinates);
-    int pinkSize = pinkCoordinates.size();
+    MaskStatistics pinkStatistics = getMaskStatistics(maskPink);
+    int pinkX = pinkStatistics.averageX;
+    int pinkY = pinkStatistics.averageY;
+    int pinkSize = pinkStatistics.count;
 
     // Adjust pink coordinates for the cropped region
     if (pinkY >= 0) pinkY += cropHeight;
@@ -125,46 +175,139 @@ ImageProcessingResult processImage(const cv::Mat &image) {
     return result;
 }
 
+ImageProcessingResult processImage(const cv::Mat &image) {
+    TRACE_SCOPE("processImage");
+    // Remove the top 40% of the image
+    int cropHeight = static_cast<int>(image.rows * CROP_PERCENT);
+    cv::Rect cropRegion(0, cropHeight, image.cols, image.rows - cropHeight);
+    cv::Mat croppedImage = image(cropRegion);
 
-cv::Mat filterAllColors(const cv::Mat &image) {
-    cv::Mat hsvImage, maskBlue, maskOrange, maskRed1, maskRed2, maskRed, maskGreen1, maskGreen2, maskGreen, maskPink;
-    cv::Mat filledBlue, filledOrange, filledRed, filledGreen, filledPink, finalImage;
+    cv::Mat labels;
+    classifyColors(croppedImage, labels);
+    return processLabels(labels, cropHeight);
+}
 
-    // Convert the image to HSV color space
-    cv::cvtColor(image, hsvImage, cv::COLOR_BGR2HSV);
+ImageProcessingResult processImage(const cv::Mat &image, const ColorLookupTable &colorTable) {
+    TRACE_SCOPE("processImage");
+    int cropHeight = static_cast<int>(image.rows * CROP_PERCENT);
+    cv::Rect cropRegion(0, cropHeight, image.cols, image.rows - cropHeight);
+
+    cv::Mat labels;
+    colorTable.classify(image(cropRegion), labels);
+    return processLabels(labels, cropHeight);
+}
 
-    // Create masks for each color range
-    cv::inRange(hsvImage, lowerBlueLine, upperBlueLine, maskBlue);
-    cv::inRange(hsvImage, lowerOrangeLine, upperOrangeLine, maskOrange);
-    cv::inRange(hsvImage, lowerRed1Light, upperRed1Light, maskRed1);
-    cv::inRange(hsvImage, lowerRed2Light, upperRed2Light, maskRed2);
-    cv::inRange(hsvImage, lowerGreen1Light, upperGreen1Light, maskGreen1);
-    cv::inRange(hsvImage, lowerGreen2Light, upperGreen2Light, maskGreen2);
-    cv::inRange(hsvImage, lowerPinkLight, upperPinkLight, maskPink);
 
-    // Merge two red masks
-    maskRed = maskRed1 | maskRed2;
-    maskGreen = maskGreen1 | maskGreen2;
+ImageProcessingResult processImagePyramid(const cv::Mat &image, int downscale) {
+    TRACE_SCOPE("processImagePyramid");
+    int cropHeight = static_cast<int>(image.rows * CROP_PERCENT);
+    cv::Rect cropRegion(0, cropHeight, image.cols, image.rows - cropHeight);
+    cv::Mat croppedImage = image(cropRegion);
+    if (downscale <= 1) {
+        cv::Mat labels;
+        classifyColors(croppedImage, labels);
+        return processLabels(labels, cropHeight);
+    }
 
+    // Strided subsample, every coarse label is the exact label of one full resolution pixel
+    cv::Mat coarseImage, coarseLabels;
+    cv::resize(croppedImage, coarseImage, cv::Size(), 1.0 / downscale, 1.0 / downscale, cv::INTER_NEAREST);
+    classifyColors(coarseImage, coarseLabels);
+
+    // Half the full resolution area limits, so blobs near a limit are still refined and decided there.
+    // Blobs are measured by their sampled pixels, each standing for downscale x downscale pixels:
+    // contourArea of a strided contour is 0 for a one coarse pixel wide line and far too small for small blocks.
+    const std::pair<uint8_t, int> candidateColors[] = {
+        {LABEL_BLUE, minBlueLineArea / 2},
+        {LABEL_ORANGE, minOrangeLineArea / 2},
+        {LABEL_RED, minRedLineArea / 2},
+        {LABEL_GREEN, minGreenLineArea / 2},
+        {LABEL_PINK, 0},
+    };
+    const double coarsePixelArea = static_cast<double>(downscale) * downscale;
+    const cv::Rect croppedBounds(0, 0, croppedImage.cols, croppedImage.rows);
+
+    std::vector<cv::Rect> refineRegions;
+    cv::Mat coarseMask;
+    std::vector<std::vector<cv::Point>> contours;
+    for (const auto &[label, minArea] : candidateColors) {
+        cv::bitwise_and(coarseLabels, cv::Scalar(label), coarseMask);
+        cv::findContours(coarseMask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+        for (const auto &contour : contours) {
+            cv::Rect box = cv::boundingRect(contour);
+            if (cv::countNonZero(coarseMask(box)) * coarsePixelArea < minArea) continue;
+
+            // One coarse pixel of padding covers the full resolution pixels that were skipped
+            cv::Rect region((box.x - 1) * downscale, (box.y - 1) * downscale, (box.width + 2) * downscale, (box.height + 2) * downscale);
+            refineRegions.push_back(region & croppedBounds);
+        }
+    }
 
-    // Create colored images for each mask
-    filledBlue = cv::Mat::zeros(image.size(), image.type());
-    filledBlue.setTo(cv::Scalar(255, 0, 0), maskBlue); // Blue (BGR format)
+    // Labels stay zero outside the refined regions, processLabels then sees exactly the candidates
+    cv::Mat labels = cv::Mat::zeros(croppedImage.size(), CV_8UC1);
+    cv::Mat regionLabels;
+    for (const auto &region : refineRegions) {
+        if (region.empty()) continue;
+        classifyColors(croppedImage(region), regionLabels);
+        regionLabels.copyTo(labels(region));
+    }
 
-    filledOrange = cv::Mat::zeros(image.size(), image.type());
-    filledOrange.setTo(cv::Scalar(0, 165, 255), maskOrange); // Orange (BGR format)
+    return processLabels(labels, cropHeight);
+}
 
-    filledRed = cv::Mat::zeros(image.size(), image.type());
-    filledRed.setTo(cv::Scalar(0, 0, 255), maskRed); // Red (BGR format)
+void classifyColors(const cv::Mat &image, cv::Mat &labels) {
+    TRACE_SCOPE("classifyColors");
+    labels.create(image.size(), CV_8UC1);
+
+    // cvtColor runs on a few rows at a time so the HSV strip stays in cache and is classified
+    // right away, the full HSV image is never written out and read back seven times
+    const int stripRows = 8;
+    int stripCount = (image.rows + stripRows - 1) / stripRows;
+    cv::parallel_for_(cv::Range(0, stripCount), [&](const cv::Range &strips) {
+        cv::Mat hsvStrip;
+        for (int strip = strips.start; strip < strips.end; strip++) {
+            int top = strip * stripRows;
+            int bottom = std::min(top + stripRows, image.rows);
+            cv::cvtColor(image.rowRange(top, bottom), hsvStrip, cv::COLOR_BGR2HSV);
+            for (int y = top; y < bottom; y++) {
+                classifyHsvRow(hsvStrip.ptr<uchar>(y - top), labels.ptr<uchar>(y), image.cols);
+            }
+        }
+    });
+}
 
-    filledGreen = cv::Mat::zeros(image.size(), image.type());
-    filledGreen.setTo(cv::Scalar(0, 255, 0), maskGreen); // Green (BGR format)
 
-    filledPink = cv::Mat::zeros(image.size(), image.type());
-    filledPink.setTo(cv::Scalar(203, 192, 255), maskPink); // Pink (BGR format)
+cv::Mat filterAllColors(const cv::Mat &image) {
+    TRACE_SCOPE("filterAllColors");
+    cv::Mat labels;
+    classifyColors(image, labels);
+
+    // Color of every label combination, overlapping ranges OR their colors like the separate masks did
+    const std::pair<uint8_t, cv::Vec3b> labelColors[] = {
+        {LABEL_BLUE, cv::Vec3b(255, 0, 0)},      // Blue (BGR format)
+        {LABEL_ORANGE, cv::Vec3b(0, 165, 255)},  // Orange (BGR format)
+        {LABEL_RED, cv::Vec3b(0, 0, 255)},       // Red (BGR format)
+        {LABEL_GREEN, cv::Vec3b(0, 255, 0)},     // Green (BGR format)
+        {LABEL_PINK, cv::Vec3b(203, 192, 255)},  // Pink (BGR format)
+    };
+    cv::Vec3b palette[256];
+    for (int label = 0; label < 256; label++) {
+        palette[label] = cv::Vec3b(0, 0, 0);
+        for (const auto &[bit, color] : labelColors) {
+            if (label & bit) {
+                for (int c = 0; c < 3; c++) palette[label][c] |= color[c];
+            }
+        }
+    }
 
-    // Combine all filled masks into the final image
-    finalImage = filledBlue | filledOrange | filledRed | filledGreen | filledPink;
+    cv::Mat finalImage(image.size(), CV_8UC3);
+    for (int y = 0; y < labels.rows; y++) {
+        const uchar *labelRow = labels.ptr<uchar>(y);
+        cv::Vec3b *outputRow = finalImage.ptr<cv::Vec3b>(y);
+        for (int x = 0; x < labels.cols; x++) {
+            outputRow[x] = palette[labelRow[x]];
+        }
+    }
 
     return finalImage;
 }
@@ -1,6 +1,7 @@
 #ifndef IMAGE_PROCESSOR_H
 #define IMAGE_PROCESSOR_H
 
+#include <cstdint>
 #include <opencv2/opencv.hpp>
 #include <string>
 #include <vector>
@@ -23,6 +24,24 @@ const cv::Scalar upperGreen2Light(84, 175, 195);
 const cv::Scalar lowerPinkLight(165, 244, 200);
 const cv::Scalar upperPinkLight(171, 255, 255);
 
+// Bits of the label image written by classifyColors. The ranges above may overlap, so a pixel can carry several.
+// The two red and the two green ranges share one bit each.
+const uint8_t LABEL_BLUE = 1 << 0;
+const uint8_t LABEL_ORANGE = 1 << 1;
+const uint8_t LABEL_RED = 1 << 2;
+const uint8_t LABEL_GREEN = 1 << 3;
+const uint8_t LABEL_PINK = 1 << 4;
+
+// One inclusive HSV range and the label bit a pixel inside it gets
+struct ColorRange {
+    cv::Scalar lower;
+    cv::Scalar upper;
+    uint8_t label;
+};
+
+// The ranges above with their labels, the input of classifyColors and ColorLookupTable::build
+const std::vector<ColorRange> &defaultColorRanges();
+
 const int minBlueLineArea = 37;
 const int minOrangeLineArea = 37;
 const int minRedLineArea = 300;
@@ -57,13 +76,33 @@ struct ImageProcessingResult {
     int pinkSize;
 };
 
+// Pixel count and mean position of the non-zero pixels of a mask, the means are -1 for an empty mask
+struct MaskStatistics {
+    int count;
+    int averageX;
+    int averageY;
+};
+
 // Function declarations
-std::vector<cv::Point> getCoordinates(const cv::Mat &mask);
-int getAverageX(const std::vector<cv::Point> &coordinates);
-int getAverageY(const std::vector<cv::Point> &coordinates);
+MaskStatistics getMaskStatistics(const cv::Mat &mask);
 std::tuple<cv::Point, double, cv::Point> getCentroidAndArea(const std::vector<cv::Point> &contour);
 ImageProcessingResult processImage(const cv::Mat &image);
 
+// Coarse-to-fine processImage: color blobs are found on the cropped frame subsampled by downscale (2 or 4),
+// then only padded boxes around them are classified at full resolution. Same result coordinates as processImage,
+// but pixels outside the boxes (specks too small to pass the area filters, scattered pink) are not counted,
+// and features thinner than downscale pixels can fall between the sampled rows and columns.
+ImageProcessingResult processImagePyramid(const cv::Mat &image, int downscale);
+
+class ColorLookupTable;
+
+// Same as processImage, classifying the pixels with a precomputed table instead of the HSV ranges
+ImageProcessingResult processImage(const cv::Mat &image, const ColorLookupTable &colorTable);
+
+// Classifies every pixel of a BGR image against all color ranges in one pass over the image.
+// labels becomes a CV_8UC1 image of LABEL_* bits, the same as OR-ing the inRange masks of the HSV image.
+void classifyColors(const cv::Mat &image, cv::Mat &labels);
+
 // New function declaration
 cv::Mat filterAllColors(const cv::Mat &image);
 
@@ -25,7 +25,7 @@ PiCamera::PiCamera()
     still_flags |= LibcameraApp::FLAG_STILL_RGB;
     running.store(false, std::memory_order_release);;
     frameready.store(false, std::memory_order_release);;
-    framebuffer=nullptr;
+    videostream=nullptr;
     camerastarted=false;
 }
 
@@ -136,6 +136,16 @@ void PiCamera::stopVideo()
 
 bool PiCamera::getVideoFrame(cv::Mat &frame, unsigned int timeout)
 {
+    FrameLease lease;
+    if(!leaseVideoFrame(lease, timeout))
+        return false;
+    lease.image().copyTo(frame);
+    return true;
+}
+
+bool PiCamera::leaseVideoFrame(FrameLease &lease, unsigned int timeout)
+{
+    lease.release();
     if(!running.load(std::memory_order_acquire))return false;
     auto start_time = std::chrono::high_resolution_clock::now();
     bool timeout_reached = false;
@@ -146,32 +156,28 @@ bool PiCamera::getVideoFrame(cv::Mat &frame, unsigned int timeout)
         nanosleep(&req,NULL);
         timeout_reached = (std::chrono::high_resolution_clock::now() - start_time > std::chrono::milliseconds(timeout));
     }
-    if(frameready.load(std::memory_order_acquire)){
-        frame.create(vh,vw,CV_8UC3);
-        uint ls = vw*3;
-        mtx.lock();
-            uint8_t *ptr = framebuffer;
-            for (unsigned int i = 0; i < vh; i++, ptr += vstr)
-                memcpy(frame.ptr(i),ptr,ls);
-        mtx.unlock();
-        frameready.store(false, std::memory_order_release);;
-        return true;
-    }
-    else
+    if(!frameready.load(std::memory_order_acquire))
         return false;
+
+    mtx.lock();
+        lease.payload = std::move(latestrequest);
+        latestrequest.reset();
+        frameready.store(false, std::memory_order_release);
+    mtx.unlock();
+    if(!lease.payload)
+        return false;
+
+    //Header over the mmapped buffer, the row stride of libcamera is kept
+    const std::vector<libcamera::Span<uint8_t>> mem = app->Mmap(lease.payload->buffers[videostream]);
+    lease.frame = cv::Mat(vh, vw, CV_8UC3, mem[0].data(), vstr);
+    return true;
 }
 
 void *PiCamera::videoThreadFunc(void *p)
 {
     PiCamera *t = (PiCamera *)p;
     t->running.store(true, std::memory_order_release);
-    //allocate framebuffer
-    //unsigned int vw,vh,vstr;
-    libcamera::Stream *stream = t->app->ViewfinderStream(&t->vw,&t->vh,&t->vstr);
-    int buffersize=t->vh*t->vstr;
-    if(t->framebuffer)delete[] t->framebuffer;
-    t->framebuffer=new uint8_t[buffersize];
-    std::vector<libcamera::Span<uint8_t>> mem;
+    t->videostream = t->app->ViewfinderStream(&t->vw,&t->vh,&t->vstr);
 
     //main loop
     while(t->running.load(std::memory_order_acquire)){
@@ -184,17 +190,17 @@ void *PiCamera::videoThreadFunc(void *p)
             throw std::runtime_error("unrecognised message!");
 
 
+        //No copy, the request itself is published. A frame nobody took is dropped here and its buffer requeued.
         CompletedRequestPtr payload = std::get<CompletedRequestPtr>(msg.payload);
-        mem = t->app->Mmap(payload->buffers[stream]);
         t->mtx.lock();
-            memcpy(t->framebuffer,mem[0].data(),buffersize);
+            std::swap(t->latestrequest, payload);
         t->mtx.unlock();
+        payload.reset();
         t->frameready.store(true, std::memory_order_release);
     }
-    if(t->framebuffer){
-        delete[] t->framebuffer;
-        t->framebuffer=nullptr;
-    }
+    t->mtx.lock();
+        t->latestrequest.reset();
+    t->mtx.unlock();
     return NULL;
 }
 
@@ -11,6 +11,31 @@
 
 namespace lccv {
 
+/**
+ * A video frame that points straight into the mmapped libcamera buffer.
+ *
+ * The buffer is handed back to the camera when the lease is released or destroyed, so hold it only
+ * while the frame is processed, and release it before PiCamera::stopVideo. image() must not be used
+ * after that; copy it if it has to live longer.
+ */
+class FrameLease {
+public:
+    FrameLease() = default;
+
+    const cv::Mat &image() const { return frame; }
+    bool valid() const { return payload != nullptr; }
+
+    void release() {
+        frame.release();
+        payload.reset();
+    }
+
+private:
+    friend class PiCamera;
+    cv::Mat frame;
+    CompletedRequestPtr payload;
+};
+
 class PiCamera {
 public:
     PiCamera();
@@ -26,6 +51,10 @@ public:
     //Video mode
     bool startVideo();
     bool getVideoFrame(cv::Mat &frame, unsigned int timeout);
+    //Zero-copy variant of getVideoFrame, the lease keeps the libcamera buffer out of the camera until released.
+    //Orientation changes belong in options->transform, which the sensor applies for free; startVideo()
+    //throws if the sensor cannot apply it, rather than handing out frames the wrong way up.
+    bool leaseVideoFrame(FrameLease &lease, unsigned int timeout);
     void stopVideo();
 
     //Applies new zoom options. Before invoking this func modify options->roi.
@@ -41,7 +70,8 @@ protected:
     unsigned int still_flags;
     unsigned int vw,vh,vstr;
     std::atomic<bool> running,frameready;
-    uint8_t *framebuffer;
+    libcamera::Stream *videostream;
+    CompletedRequestPtr latestrequest;   //Newest completed request not yet handed out, guarded by mtx
     std::mutex mtx;
     bool camerastarted;
 };
@@ -8,6 +8,8 @@
 #include "libcamera_app.hpp"
 #include "libcamera_app_options.hpp"
 
+#include <sstream>
+
 LibcameraApp::LibcameraApp(std::unique_ptr<Options> opts)
 	: options_(std::move(opts)), controls_(controls::controls)
 
@@ -101,7 +103,8 @@ void LibcameraApp::ConfigureStill(unsigned int flags)
     if (options_->photo_height)
         configuration_->at(0).size.height = options_->photo_height;
 
-//    configuration_->transform = options_->transform;
+    // Flips happen in the sensor readout, so frames need no cv::flip afterwards
+    configuration_->orientation = libcamera::Orientation::Rotate0 * options_->transform;
 
 	//if (have_raw_stream && !options_->rawfull)
 	{
@@ -136,7 +139,8 @@ void LibcameraApp::ConfigureViewfinder()
     configuration_->at(0).size.height = options_->video_height;
     configuration_->at(0).bufferCount = 4;
 
-//    configuration_->transform = options_->transform;
+    // Flips happen in the sensor readout, so frames need no cv::flip afterwards
+    configuration_->orientation = libcamera::Orientation::Rotate0 * options_->transform;
 
     configureDenoise(options_->denoise == "auto" ? "cdn_off" : options_->denoise);
     setupCapture();
@@ -421,12 +425,23 @@ void LibcameraApp::setupCapture()
 {
 	// First finish setting up the configuration.
 
+	libcamera::Orientation requestedOrientation = configuration_->orientation;
 	CameraConfiguration::Status validation = configuration_->validate();
 	if (validation == CameraConfiguration::Invalid)
 		throw std::runtime_error("failed to valid stream configurations");
 	else if (validation == CameraConfiguration::Adjusted)
 		std::cerr << "Stream configuration adjusted" << std::endl;
 
+	// Frames are leased straight from the buffers, so nothing downstream flips them; a sensor
+	// that silently drops the requested transform would hand out images the wrong way up.
+	if (configuration_->orientation != requestedOrientation)
+	{
+		std::ostringstream message;
+		message << "camera does not support orientation " << requestedOrientation << " (got "
+				<< configuration_->orientation << "), flip the frames in software instead";
+		throw std::runtime_error(message.str());
+	}
+
 	if (camera_->configure(configuration_.get()) < 0)
 		throw std::runtime_error("failed to configure streams");
 	if (options_->verbose)
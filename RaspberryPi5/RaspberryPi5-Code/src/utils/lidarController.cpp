@@ -1,12 +1,14 @@
 #include "lidarController.h"
 
+#include <algorithm>
+
 using namespace sl;
 
 namespace lidarController
 {
 
   LidarController::LidarController(const char *serialPort, int baudRate)
-      : serialPort(serialPort), baudRate(baudRate), lidarDriver(nullptr), serialChannel(nullptr) {}
+      : serialPort(serialPort), baudRate(baudRate), lidarDriver(nullptr), serialChannel(nullptr), rawNodes(MAX_SCAN_NODES) {}
 
   LidarController::~LidarController()
   {
@@ -85,24 +87,99 @@ namespace lidarController
 
   std::vector<NodeData> LidarController::getScanData()
   {
-    sl_lidar_response_measurement_node_hq_t nodes[8192];
-    size_t nodeCount = sizeof(nodes) / sizeof(sl_lidar_response_measurement_node_hq_t);
+    std::vector<NodeData> nodeDataVector;
+    getScanData(nodeDataVector);
+    return nodeDataVector;
+  }
 
-    sl_result result = lidarDriver->grabScanDataHq(nodes, nodeCount);
+  bool LidarController::getScanData(std::vector<NodeData>& nodeDataVector)
+  {
+    nodeDataVector.clear();
+    if (!lidarDriver)
+      return false;
+
+    size_t nodeCount = rawNodes.size();
+    sl_result result = lidarDriver->grabScanDataHq(rawNodes.data(), nodeCount);
     if (SL_IS_FAIL(result))
-      return {};
+      return false;
 
-    std::vector<NodeData> nodeDataVector(nodeCount);
+    lidarDriver->ascendScanData(rawNodes.data(), nodeCount);
 
-    lidarDriver->ascendScanData(nodes, nodeCount);
+    nodeDataVector.resize(nodeCount);
     for (size_t i = 0; i < nodeCount; ++i)
     {
-      float angle = nodes[i].angle_z_q14 * 90.f / (1 << 14);
-      float distance = nodes[i].dist_mm_q2 / 1000.f / (1 << 2);
+      float angle = rawNodes[i].angle_z_q14 * 90.f / (1 << 14);
+      float distance = rawNodes[i].dist_mm_q2 / 1000.f / (1 << 2);
       nodeDataVector[i] = {angle, distance};
     }
 
-    return nodeDataVector;
+    return true;
+  }
+
+  void LidarController::reserveScanBuffer(std::vector<NodeData>& nodeDataVector)
+  {
+    nodeDataVector.reserve(MAX_SCAN_NODES);
+  }
+
+  bool LidarController::startStreaming()
+  {
+    if (!lidarDriver)
+      return false;
+    if (streaming)
+      return true;
+
+    // Reserve every slot up front so the streaming thread never allocates
+    for (auto& scan : scanBuffer.allBuffers())
+      reserveScanBuffer(scan.nodes);
+
+    streaming = true;
+    streamingThread = std::thread(&LidarController::streamingLoop, this);
+    return true;
+  }
+
+  void LidarController::stopStreaming()
+  {
+    streaming = false;
+    if (streamingThread.joinable())
+      streamingThread.join();
+  }
+
+  const LidarScan& LidarController::getLatestScan()
+  {
+    scanBuffer.update();
+    return scanBuffer.readBuffer();
+  }
+
+  void LidarController::streamingLoop()
+  {
+    // A disconnected or stopped lidar makes grabScanDataHq fail immediately, so back off
+    // instead of spinning on it and report the outage once it lasts
+    const auto maxBackoff = std::chrono::milliseconds(100);
+    auto backoff = std::chrono::milliseconds(1);
+    int failedScans = 0;
+
+    while (streaming)
+    {
+      LidarScan& scan = scanBuffer.writeBuffer();
+      if (!getScanData(scan.nodes) || scan.nodes.empty())
+      {
+        failedScans++;
+        if (failedScans == FAILED_SCANS_REPORTED || failedScans % (FAILED_SCANS_REPORTED * 10) == 0)
+          std::cerr << "LIDAR: " << failedScans << " consecutive scans failed." << std::endl;
+        std::this_thread::sleep_for(backoff);
+        backoff = std::min(backoff * 2, maxBackoff);
+        continue;
+      }
+      if (failedScans >= FAILED_SCANS_REPORTED)
+        std::cerr << "LIDAR: scanning recovered after " << failedScans << " failed scans." << std::endl;
+      failedScans = 0;
+      backoff = std::chrono::milliseconds(1);
+
+      // grabScanDataHq returns as soon as a rotation is complete
+      scan.timestamp = std::chrono::steady_clock::now();
+      scan.sequence = ++scanSequence;
+      scanBuffer.publish();
+    }
   }
 
   void LidarController::stopScanning()
@@ -116,6 +193,7 @@ namespace lidarController
 
   void LidarController::shutdown()
   {
+    stopStreaming();
     stopScanning();
 
     if (lidarDriver)
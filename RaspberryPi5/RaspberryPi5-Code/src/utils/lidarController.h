@@ -8,8 +8,11 @@
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
+#include <thread>
+#include <atomic>
 
 #include "lidar_struct.h"
+#include "tripleBuffer.h"
 
 namespace lidarController {
   
@@ -48,12 +51,51 @@ namespace lidarController {
      */
     void stopScanning();
 
+    /**
+     * Largest number of nodes a single scan can hold.
+     */
+    static constexpr size_t MAX_SCAN_NODES = 8192;
+
     /**
      * Retrieves scan data from the LIDAR, including angles and distances.
      * @return A vector of NodeData containing scan results.
      */
     std::vector<NodeData> getScanData();
 
+    /**
+     * Retrieves scan data into a caller-owned buffer. Once the buffer has reached
+     * MAX_SCAN_NODES capacity (see reserveScanBuffer) this performs no heap allocation.
+     * @param nodeDataVector - Buffer that is resized to the scan and filled.
+     * @return true if a scan was retrieved, false otherwise.
+     */
+    bool getScanData(std::vector<NodeData>& nodeDataVector);
+
+    /**
+     * Reserves MAX_SCAN_NODES entries in a scan buffer so later getScanData calls never reallocate it.
+     * @param nodeDataVector - Buffer to reserve.
+     */
+    static void reserveScanBuffer(std::vector<NodeData>& nodeDataVector);
+
+    /**
+     * Starts a background thread that grabs scans continuously and publishes
+     * each complete rotation to a lock-free latest-scan mailbox.
+     * While streaming, getScanData() must not be called from other threads.
+     * @return true if the thread is running.
+     */
+    bool startStreaming();
+
+    /**
+     * Stops the background acquisition thread and waits for it to exit.
+     */
+    void stopStreaming();
+
+    /**
+     * Returns the newest scan published by the streaming thread without blocking.
+     * The reference stays valid until the next call. Must only be called from one thread.
+     * @return The latest LidarScan, with sequence 0 if no scan has arrived yet.
+     */
+    const LidarScan& getLatestScan();
+
     /**
      * Shuts down the LIDAR, stops scanning, and cleans up all resources.
      */
@@ -70,6 +112,20 @@ namespace lidarController {
     sl::IChannel* serialChannel;    ///< Pointer to the communication channel.
     const char* serialPort;         ///< Serial port used for LIDAR connection.
     int baudRate;                   ///< Baud rate for the communication.
+
+    std::vector<sl_lidar_response_measurement_node_hq_t> rawNodes;  ///< Reused driver buffer of MAX_SCAN_NODES entries.
+
+    TripleBuffer<LidarScan> scanBuffer;  ///< Hands finished scans from the streaming thread to the reader.
+    std::thread streamingThread;         ///< Background acquisition thread.
+    std::atomic<bool> streaming{false};  ///< Keeps the streaming thread running while true.
+    uint64_t scanSequence = 0;           ///< Last sequence number published, only touched by the streaming thread.
+
+    static constexpr int FAILED_SCANS_REPORTED = 10;  ///< Consecutive failed scans before the streaming thread reports them.
+
+    /**
+     * Body of the streaming thread, backs off while scans keep failing.
+     */
+    void streamingLoop();
   };
 
 }
@@ -1,13 +1,22 @@
 #include "lidarDataProcessor.h"
 
+#include <algorithm>
 #include <cmath>
 
+#include "trace.h"
+
 // Convert LIDAR data to an OpenCV image for Hough Line detection
 cv::Mat lidarDataToImage(const std::vector<lidarController::NodeData>& data, int width, int height, float scale) {
+    return lidarDataToImage(data.data(), data.size(), width, height, scale);
+}
+
+cv::Mat lidarDataToImage(const lidarController::NodeData* data, size_t count, int width, int height, float scale) {
+    TRACE_SCOPE("lidarDataToImage");
     cv::Mat image = cv::Mat::zeros(height, width, CV_8UC1);  // Grayscale image for binary line detection
     cv::Point center(width / 2, height / 2);
 
-    for (const auto& point : data) {
+    for (size_t i = 0; i < count; i++) {
+        const auto& point = data[i];
         if (point.distance < 0.005)
             continue;
         if (point.distance > 3.200)
@@ -34,11 +43,219 @@ float toMeter(int scale, double lidarDistance) {
 
 // Detect lines using Hough Transform
 std::vector<cv::Vec4i> detectLines(const cv::Mat& binaryImage) {
+    TRACE_SCOPE("detectLines");
     std::vector<cv::Vec4i> lines;
     cv::HoughLinesP(binaryImage, lines, 1, CV_PI / 180, 20, 60, 30);
     return lines;
 }
 
+// Moves lines found in an image region back into the coordinates of the full image
+static void offsetLines(std::vector<cv::Vec4i>& lines, const cv::Point& offset) {
+    for (auto& line : lines) {
+        line[0] += offset.x;
+        line[1] += offset.y;
+        line[2] += offset.x;
+        line[3] += offset.y;
+    }
+}
+
+std::vector<cv::Vec4i> detectLines(const cv::Mat& binaryImage, const cv::Rect& roi) {
+    std::vector<cv::Vec4i> lines;
+    if (roi.empty()) return lines;
+
+    lines = detectLines(binaryImage(roi));
+    offsetLines(lines, roi.tl());
+    return lines;
+}
+
+// Fit a line through points[begin, end) by least squares and clip it to the first and last point
+static cv::Vec4i fitScanLine(const std::vector<cv::Point2f>& points, size_t begin, size_t end) {
+    double meanX = 0, meanY = 0;
+    for (size_t i = begin; i < end; ++i) {
+        meanX += points[i].x;
+        meanY += points[i].y;
+    }
+    double count = static_cast<double>(end - begin);
+    meanX /= count;
+    meanY /= count;
+
+    double sxx = 0, syy = 0, sxy = 0;
+    for (size_t i = begin; i < end; ++i) {
+        double dx = points[i].x - meanX;
+        double dy = points[i].y - meanY;
+        sxx += dx * dx;
+        syy += dy * dy;
+        sxy += dx * dy;
+    }
+
+    // Principal axis of the point cloud
+    double theta = 0.5 * std::atan2(2.0 * sxy, sxx - syy);
+    double dirX = std::cos(theta);
+    double dirY = std::sin(theta);
+
+    auto project = [&](const cv::Point2f& pt) {
+        double t = (pt.x - meanX) * dirX + (pt.y - meanY) * dirY;
+        return cv::Point(cvRound(meanX + t * dirX), cvRound(meanY + t * dirY));
+    };
+
+    cv::Point first = project(points[begin]);
+    cv::Point last = project(points[end - 1]);
+    return cv::Vec4i(first.x, first.y, last.x, last.y);
+}
+
+// Project the points exactly like lidarDataToImage does, keeping the scan order.
+// The scan wraps around at 360 degrees, so the result starts at a gap larger than maxPointGap if there is one,
+// which keeps an object crossing 0 degree in one run of consecutive points.
+static std::vector<cv::Point2f> projectScanPoints(const std::vector<lidarController::NodeData>& data, int width, int height, float scale, double maxPointGap) {
+    cv::Point center(width / 2, height / 2);
+
+    std::vector<cv::Point2f> points;
+    points.reserve(data.size());
+    for (const auto& point : data) {
+        if (point.distance < 0.005)
+            continue;
+        if (point.distance > 3.200)
+            continue;
+        if (point.angle > 5 && point.angle < 175 && point.distance > 0.700)
+            continue;
+
+        float angle_rad = point.angle * CV_PI / 180.0;
+        float x = center.x + point.distance * scale * cos(angle_rad);
+        float y = center.y + point.distance * scale * sin(angle_rad);
+
+        if (x >= 0 && x < width && y >= 0 && y < height) {
+            points.emplace_back(x, y);
+        }
+    }
+
+    if (points.size() > 1 && cv::norm(points.front() - points.back()) <= maxPointGap) {
+        for (size_t i = 1; i < points.size(); ++i) {
+            if (cv::norm(points[i] - points[i - 1]) > maxPointGap) {
+                std::rotate(points.begin(), points.begin() + i, points.end());
+                break;
+            }
+        }
+    }
+
+    return points;
+}
+
+std::vector<cv::Vec4i> detectScanLines(const std::vector<lidarController::NodeData>& data, int width, int height, float scale) {
+    TRACE_SCOPE("detectScanLines");
+    constexpr double MAX_POINT_GAP = 30.0;     // Pixels, same role as maxLineGap in detectLines
+    constexpr double MIN_LINE_LENGTH = 60.0;   // Pixels, same role as minLineLength in detectLines
+    constexpr double MAX_SPLIT_DISTANCE = 0.025;  // Meters a point may be away from its segment
+    constexpr size_t MIN_POINTS_PER_LINE = 5;
+
+    double maxSplitDistance = MAX_SPLIT_DISTANCE * scale;
+
+    std::vector<cv::Point2f> points = projectScanPoints(data, width, height, scale, MAX_POINT_GAP);
+
+    std::vector<cv::Vec4i> lines;
+    if (points.size() < MIN_POINTS_PER_LINE) return lines;
+
+    // Distance of the point farthest away from the chord of points[begin, end)
+    auto farthestFromChord = [&](size_t begin, size_t end) {
+        cv::Point2f chord = points[end - 1] - points[begin];
+        double chordLength = cv::norm(chord);
+
+        std::pair<size_t, double> farthest(begin, 0.0);
+        if (chordLength == 0) return farthest;
+
+        for (size_t j = begin + 1; j + 1 < end; ++j) {
+            cv::Point2f offset = points[j] - points[begin];
+            double distance = std::abs(chord.x * offset.y - chord.y * offset.x) / chordLength;
+            if (distance > farthest.second) {
+                farthest = {j, distance};
+            }
+        }
+        return farthest;
+    };
+
+    std::vector<std::pair<size_t, size_t>> pending;
+    std::vector<std::pair<size_t, size_t>> pieces;
+    size_t runStart = 0;
+    for (size_t i = 1; i <= points.size(); ++i) {
+        if (i < points.size() && cv::norm(points[i] - points[i - 1]) <= MAX_POINT_GAP) continue;
+
+        // Split: break the run of consecutive points at its farthest point until every piece is straight
+        pieces.clear();
+        pending.emplace_back(runStart, i);
+        runStart = i;
+
+        while (!pending.empty()) {
+            auto [begin, end] = pending.back();
+            pending.pop_back();
+
+            auto [farthestIndex, farthestDistance] = farthestFromChord(begin, end);
+            if (farthestDistance > maxSplitDistance) {
+                pending.emplace_back(farthestIndex, end);      // Pushed first so the pieces come out in scan order
+                pending.emplace_back(begin, farthestIndex + 1);
+                continue;
+            }
+            pieces.emplace_back(begin, end);
+        }
+
+        // Merge: join neighbouring pieces that are still straight together (the split point is often off the corner)
+        size_t merged = 0;
+        for (size_t j = 1; j < pieces.size(); ++j) {
+            if (farthestFromChord(pieces[merged].first, pieces[j].second).second <= maxSplitDistance) {
+                pieces[merged].second = pieces[j].second;
+            } else {
+                pieces[++merged] = pieces[j];
+            }
+        }
+        if (!pieces.empty()) pieces.resize(merged + 1);
+
+        for (const auto& [begin, end] : pieces) {
+            if (end - begin < MIN_POINTS_PER_LINE) continue;
+
+            cv::Vec4i line = fitScanLine(points, begin, end);
+            if (lineLength(line) >= MIN_LINE_LENGTH) {
+                lines.push_back(line);
+            }
+        }
+    }
+
+    return lines;
+}
+
+std::vector<cv::Point> detectScanPillars(const std::vector<lidarController::NodeData>& data, int width, int height, float scale) {
+    TRACE_SCOPE("detectScanPillars");
+    constexpr double MAX_POINT_GAP = 20.0;       // Pixels, the dilation kernel size that joins points into one blob in detectTrafficLight
+    constexpr double MAX_PILLAR_WIDTH = 0.150;   // Meters across the points of one pillar, walls are much wider
+
+    const double maxPillarWidth = MAX_PILLAR_WIDTH * scale;
+
+    std::vector<cv::Point2f> points = projectScanPoints(data, width, height, scale, MAX_POINT_GAP);
+
+    std::vector<cv::Point> pillars;
+    size_t runStart = 0;
+    for (size_t i = 1; i <= points.size(); ++i) {
+        if (i < points.size() && cv::norm(points[i] - points[i - 1]) <= MAX_POINT_GAP) continue;
+
+        // A run of consecutive points ends at a jump, keep it if it is small enough to be a pillar
+        float minX = points[runStart].x, maxX = minX;
+        float minY = points[runStart].y, maxY = minY;
+        cv::Point2f sum(0, 0);
+        for (size_t j = runStart; j < i; ++j) {
+            minX = std::min(minX, points[j].x);
+            maxX = std::max(maxX, points[j].x);
+            minY = std::min(minY, points[j].y);
+            maxY = std::max(maxY, points[j].y);
+            sum += points[j];
+        }
+
+        if (cv::norm(cv::Point2f(maxX - minX, maxY - minY)) <= maxPillarWidth) {
+            float count = static_cast<float>(i - runStart);
+            pillars.emplace_back(cvRound(sum.x / count), cvRound(sum.y / count));
+        }
+        runStart = i;
+    }
+
+    return pillars;
+}
+
 double lineLength(const cv::Vec4i& line) {
     return cv::norm(cv::Point(line[2], line[3]) - cv::Point(line[0], line[1]));
 }
@@ -89,6 +306,31 @@ double pointLinePerpendicularDirection(const cv::Point2f& pt, const cv::Vec4i& l
     return angle;
 }
 
+void WallSegments::assign(const std::vector<cv::Vec4i>& segments) {
+    const size_t count = segments.size();
+    lines = segments;
+    direction.resize(count);
+    normal.resize(count);
+    length.resize(count);
+    angle.resize(count);
+    normalAngle.resize(count);
+    offset.resize(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        const cv::Vec4i& line = segments[i];
+        float dx = line[2] - line[0];
+        float dy = line[3] - line[1];
+        float norm = std::sqrt(dx * dx + dy * dy);
+
+        length[i] = norm;
+        direction[i] = norm > 0 ? cv::Point2f(dx / norm, dy / norm) : cv::Point2f(0, 0);
+        normal[i] = cv::Point2f(-direction[i].y, direction[i].x);
+        offset[i] = normal[i].x * line[0] + normal[i].y * line[1];
+        normalAngle[i] = std::atan2(dx, -dy) * 180.0 / CV_PI;
+        angle[i] = calculateAngle(line);
+    }
+}
+
 cv::Vec4i extendLine(const cv::Vec4i& line, double factor) {
     cv::Point2f A(line[0], line[1]); // Start point
     cv::Point2f B(line[2], line[3]); // End point
@@ -133,15 +375,16 @@ bool areLinesAligned(const cv::Vec4i& line1, const cv::Vec4i& line2, double angl
     return false;
 }
 
-std::vector<cv::Vec4i> combineAlignedLines(std::vector<cv::Vec4i> lines, double angleThreshold, double collinearThreshold) {
-    // Ensure each line has its first point to the left (smaller x-coordinate) of the second point
-    auto normalizeLine = [](cv::Vec4i& line) {
-        if (line[0] > line[2] || (line[0] == line[2] && line[1] > line[3])) {
-            std::swap(line[0], line[2]);
-            std::swap(line[1], line[3]);
-        }
-    };
+// Ensure each line has its first point to the left (smaller x-coordinate) of the second point
+static void normalizeLine(cv::Vec4i& line) {
+    if (line[0] > line[2] || (line[0] == line[2] && line[1] > line[3])) {
+        std::swap(line[0], line[2]);
+        std::swap(line[1], line[3]);
+    }
+}
 
+std::vector<cv::Vec4i> combineAlignedLinesExhaustive(std::vector<cv::Vec4i> lines, double angleThreshold, double collinearThreshold) {
+    TRACE_SCOPE("combineAlignedLinesExhaustive");
     for (auto& line : lines) {
         normalizeLine(line);
     }
@@ -225,17 +468,192 @@ std::vector<cv::Vec4i> combineAlignedLines(std::vector<cv::Vec4i> lines, double
     return lines;
 }
 
+namespace {
+
+// Lines of one angle bin, sorted by the offset of their midpoint along the normal of the bin
+struct AngleBin {
+    cv::Point2d normal;
+    std::vector<std::pair<double, int>> offsets;  // Midpoint offset, line index
+    double maxHalfSpan = 0.0;                      // Largest half extent of a line along the normal
+};
+
+}  // namespace
+
+// Clips the infinite line through a segment to the box [minX, maxX] x [minY, maxY]. Any point in the box that is
+// collinear with the line lies near this part of it, which bounds where an aligned segment can be.
+static void clipLineToBox(const cv::Vec4i& line, double minX, double minY, double maxX, double maxY, cv::Point2d& first, cv::Point2d& second) {
+    cv::Point2d start(line[0], line[1]);
+    cv::Point2d direction(line[2] - line[0], line[3] - line[1]);
+
+    double tMin = -1e12;
+    double tMax = 1e12;
+    auto clip = [&](double origin, double step, double low, double high) {
+        if (step == 0.0) return;
+        double t0 = (low - origin) / step;
+        double t1 = (high - origin) / step;
+        if (t0 > t1) std::swap(t0, t1);
+        tMin = std::max(tMin, t0);
+        tMax = std::min(tMax, t1);
+    };
+    clip(start.x, direction.x, minX, maxX);
+    clip(start.y, direction.y, minY, maxY);
+
+    if (direction.x == 0.0 && direction.y == 0.0) {
+        tMin = tMax = 0.0;
+    }
+    first = start + direction * tMin;
+    second = start + direction * tMax;
+}
+
+// One round of combineAlignedLinesExhaustive, with the same seeds, the same areLinesAligned test and the same
+// merge order. Instead of testing every later line, each seed only tests the lines of its own and the neighbouring
+// angle bins whose offset range reaches it. Returns false if nothing was merged.
+static bool mergeAlignedLines(std::vector<cv::Vec4i>& lines, double angleThreshold, double collinearThreshold) {
+    const size_t count = lines.size();
+    if (count < 2) return false;
+
+    // Lines closer in angle than the threshold always fall into the same or neighbouring bins
+    const int binCount = std::max(1, static_cast<int>(180.0 / angleThreshold));
+    const double binWidth = 180.0 / binCount;
+
+    double minX = lines[0][0], maxX = lines[0][0], minY = lines[0][1], maxY = lines[0][1];
+    for (const auto& line : lines) {
+        minX = std::min({minX, double(line[0]), double(line[2])});
+        maxX = std::max({maxX, double(line[0]), double(line[2])});
+        minY = std::min({minY, double(line[1]), double(line[3])});
+        maxY = std::max({maxY, double(line[1]), double(line[3])});
+    }
+
+    // A point within collinearThreshold of a line has its foot on the line inside this box
+    const double margin = collinearThreshold + 1.0;
+    std::vector<cv::Point2d> reachFirst(count), reachSecond(count);
+    std::vector<int> lineBin(count);
+
+    std::vector<AngleBin> bins(binCount);
+    for (int bin = 0; bin < binCount; ++bin) {
+        double theta = (bin + 0.5) * binWidth * CV_PI / 180.0;
+        bins[bin].normal = cv::Point2d(-std::sin(theta), std::cos(theta));
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        clipLineToBox(lines[i], minX - margin, minY - margin, maxX + margin, maxY + margin, reachFirst[i], reachSecond[i]);
+
+        lineBin[i] = static_cast<int>(calculateAngle(lines[i]) / binWidth) % binCount;
+        AngleBin& bin = bins[lineBin[i]];
+        double a = lines[i][0] * bin.normal.x + lines[i][1] * bin.normal.y;
+        double b = lines[i][2] * bin.normal.x + lines[i][3] * bin.normal.y;
+        bin.offsets.push_back({(a + b) / 2.0, static_cast<int>(i)});
+        bin.maxHalfSpan = std::max(bin.maxHalfSpan, std::abs(a - b) / 2.0);
+    }
+    for (auto& bin : bins) {
+        std::sort(bin.offsets.begin(), bin.offsets.end());
+    }
+
+    std::vector<cv::Vec4i> newLines;
+    std::vector<bool> used(count, false);
+    std::vector<int> candidates;
+    bool merged = false;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (used[i])
+            continue;
+
+        // Later unused lines whose offset range overlaps the part of line i within the box
+        candidates.clear();
+        const int searchBins[3] = {lineBin[i], (lineBin[i] + 1) % binCount, (lineBin[i] + binCount - 1) % binCount};
+        for (int search = 0; search < std::min(binCount, 3); ++search) {
+            const AngleBin& bin = bins[searchBins[search]];
+            double a = reachFirst[i].dot(bin.normal);
+            double b = reachSecond[i].dot(bin.normal);
+            double low = std::min(a, b) - margin - bin.maxHalfSpan;
+            double high = std::max(a, b) + margin + bin.maxHalfSpan;
+
+            auto it = std::lower_bound(bin.offsets.begin(), bin.offsets.end(), std::make_pair(low, -1));
+            for (; it != bin.offsets.end() && it->first <= high; ++it) {
+                if (it->second > static_cast<int>(i) && !used[it->second]) {
+                    candidates.push_back(it->second);
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        cv::Vec4i currentLine = lines[i];
+        cv::Point2f start(currentLine[0], currentLine[1]);
+        cv::Point2f end(currentLine[2], currentLine[3]);
+
+        cv::Point2f direction(end.x - start.x, end.y - start.y);
+        double magnitude = cv::norm(direction);
+        direction.x /= magnitude;
+        direction.y /= magnitude;
+
+        for (int j : candidates) {
+            cv::Vec4i otherLine = lines[j];
+            if (!areLinesAligned(currentLine, otherLine, angleThreshold, collinearThreshold))
+                continue;
+
+            // Same endpoint selection as the exhaustive version, so ties resolve identically
+            std::vector<cv::Point2f> points = {start, end, cv::Point2f(otherLine[0], otherLine[1]), cv::Point2f(otherLine[2], otherLine[3])};
+            auto projection = [&](const cv::Point2f& pt) {
+                return (pt.x - start.x) * direction.x + (pt.y - start.y) * direction.y;
+            };
+
+            double minProj = projection(points[0]);
+            double maxProj = projection(points[0]);
+            cv::Point2f minPoint = points[0];
+            cv::Point2f maxPoint = points[0];
+
+            for (const auto& pt : points) {
+                double proj = projection(pt);
+                if (proj < minProj) {
+                    minProj = proj;
+                    minPoint = pt;
+                }
+                if (proj > maxProj) {
+                    maxProj = proj;
+                    maxPoint = pt;
+                }
+            }
+
+            start = minPoint;
+            end = maxPoint;
+
+            used[j] = true;
+            merged = true;
+        }
+
+        cv::Vec4i combinedLine(start.x, start.y, end.x, end.y);
+        normalizeLine(combinedLine);
+        newLines.push_back(combinedLine);
+    }
+
+    lines = std::move(newLines);
+    return merged;
+}
+
+std::vector<cv::Vec4i> combineAlignedLines(std::vector<cv::Vec4i> lines, double angleThreshold, double collinearThreshold) {
+    TRACE_SCOPE("combineAlignedLines");
+    for (auto& line : lines) {
+        normalizeLine(line);
+    }
+
+    // A merged line is longer and can reach lines it missed before, repeat until nothing changes
+    while (mergeAlignedLines(lines, angleThreshold, collinearThreshold)) {
+    }
+
+    return lines;
+}
+
 // Function to analyze the combined lines with gyro data and classify them as Direction::NORTH, Direction::EAST, Direction::SOUTH, Direction::WEST
-std::vector<Direction> analyzeWallDirection(const std::vector<cv::Vec4i>& combinedLines, float gyroYaw, const cv::Point& center) {
+std::vector<Direction> analyzeWallDirection(const WallSegments& walls, float gyroYaw, const cv::Point& center) {
+    TRACE_SCOPE("analyzeWallDirection");
     std::vector<Direction> wallDirections;
+    wallDirections.reserve(walls.size());
 
     // Gyro yaw is assumed to be in degrees with 0° = Direction::NORTH, 90° = Direction::EAST, 180° = Direction::SOUTH, 270° = Direction::WEST
     // Adjust the combined line angles based on the gyro data.
-    for (const auto& line : combinedLines) {
-        // double lineAngle = calculateAngle(line);
-        double perpendicularLineDirection = pointLinePerpendicularDirection(center, line);
+    for (size_t i = 0; i < walls.size(); ++i) {
+        double perpendicularLineDirection = walls.perpendicularDirection(i, center);
 
-        // double relativeLineAngle = fmod(lineAngle + gyroYaw + 360.0f, 360.0f);
         double relativePerpendicularLineDirection = fmod(perpendicularLineDirection + gyroYaw - 90.0f + 360.0f, 360.0f);
 
         Direction direction = Direction::NORTH;
@@ -251,168 +669,167 @@ std::vector<Direction> analyzeWallDirection(const std::vector<cv::Vec4i>& combin
     return wallDirections;
 }
 
-std::vector<cv::Point> detectTrafficLight(const cv::Mat& binaryImage, const std::vector<cv::Vec4i>& combinedLines, const std::vector<Direction>& wallDirections, TurnDirection turnDirection, Direction direction) {
-    cv::Mat dilatedBinaryImage = binaryImage.clone();
-    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(20, 20));
-    cv::dilate(binaryImage, dilatedBinaryImage, kernel);
+std::vector<Direction> analyzeWallDirection(const std::vector<cv::Vec4i>& combinedLines, float gyroYaw, const cv::Point& center) {
+    return analyzeWallDirection(WallSegments(combinedLines), gyroYaw, center);
+}
 
-    std::vector<std::vector<cv::Point>> contours;
-    cv::findContours(dilatedBinaryImage, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+WallModel buildWallModel(const WallSegments& walls, const std::vector<Direction>& wallDirections, Direction direction) {
+    TRACE_SCOPE("buildWallModel");
+    WallModel model;
 
-    std::vector<cv::Point> trafficLightPoints;
-    for (const auto& contour : contours) {
-        double area = cv::contourArea(contour);
+    for (size_t i = 0; i < walls.size(); ++i) {
+        const cv::Vec4i& line = walls.lines[i];
+        Direction wallDirection = wallDirections[i];
 
-        if (area >= 300 && area <= 1400) {
-            cv::Moments moments = cv::moments(contour);
+        if (wallDirection == calculateRelativeDirection(direction, FRONT)) {
+            model.frontWalls.push_back(i);
+            if (model.front != -1) {
+                const cv::Vec4i& frontLine = walls.lines[model.front];
+                cv::Point2f start(line[0], line[1]);
+                cv::Point2f end(line[2], line[3]);
+                cv::Point2f newFrontMidPoint = cv::Point2f((start.x + end.x) / 2, (start.y + end.y) / 2);
 
-            int centroidX = static_cast<int>(moments.m10 / moments.m00);
-            int centroidY = static_cast<int>(moments.m01 / moments.m00);
+                cv::Point2f frontStart(frontLine[0], frontLine[1]);
+                cv::Point2f frontEnd(frontLine[2], frontLine[3]);
+                cv::Point2f frontMidPoint = cv::Point2f((frontStart.x + frontEnd.x) / 2, (frontStart.y + frontEnd.y) / 2);
 
-            cv::Point point(centroidX, centroidY);
+                if (frontMidPoint.y > newFrontMidPoint.y) { // Check if new midpoint is higher
+                    model.front = i;
+                }
+            } else {
+                model.front = i;
+            }
+        } else if (wallDirection == calculateRelativeDirection(direction, LEFT)) {
+            model.leftWalls.push_back(i);
+        } else if (wallDirection == calculateRelativeDirection(direction, RIGHT)) {
+            model.rightWalls.push_back(i);
+        }
+    }
 
-            cv::Vec4i frontLine(-1.0f, -1.0f, -1.0f, -1.0f); // Initialize with a sentinel value (-1, -1, -1, -1)
-            std::vector<cv::Vec4i> leftLines;
-            std::vector<cv::Vec4i> rightLines;
+    if (model.front == -1) return model;
 
-            for (size_t i = 0; i < combinedLines.size(); ++i) {
-                cv::Vec4i line = combinedLines[i];
-                Direction wallDirection = wallDirections[i];
+    const cv::Vec4i& frontLine = walls.lines[model.front];
+    cv::Point2f frontStart(frontLine[0], frontLine[1]);
+    cv::Point2f frontEnd(frontLine[2], frontLine[3]);
 
-                if (wallDirection == calculateRelativeDirection(direction, FRONT)) {
-                    if (not (frontLine == cv::Vec4i(-1.0f, -1.0f, -1.0f, -1.0f))) {
-                        cv::Point2f start(line[0], line[1]);
-                        cv::Point2f end(line[2], line[3]);
-                        cv::Point2f newFrontMidPoint = cv::Point2f((start.x + end.x) / 2, (start.y + end.y) / 2);
+    cv::Point2f frontLefter;
+    cv::Point2f frontRighter;
+    if (frontStart.x < frontEnd.x) {
+        frontLefter = frontStart;
+        frontRighter = frontEnd;
+    } else {
+        frontLefter = frontEnd;
+        frontRighter = frontStart;
+    }
 
-                        cv::Point2f frontStart(frontLine[0], frontLine[1]);
-                        cv::Point2f frontEnd(frontLine[2], frontLine[3]);
-                        cv::Point2f frontMidPoint = cv::Point2f((frontStart.x + frontEnd.x) / 2, (frontStart.y + frontEnd.y) / 2);
+    // Side walls that start beyond the end of the front wall belong to the next straight section
+    for (size_t rightIndex : model.rightWalls) {
+        const cv::Vec4i& rightLine = walls.lines[rightIndex];
+        cv::Point2f rightHigher = rightLine[1] < rightLine[3] ? cv::Point2f(rightLine[0], rightLine[1]) : cv::Point2f(rightLine[2], rightLine[3]);
 
-                        if (frontMidPoint.y > newFrontMidPoint.y) { // Check if new midpoint is higher
-                            frontLine = line;
-                        }
-                    } else {
-                        frontLine = line;
-                    }
-                } else if (wallDirection == calculateRelativeDirection(direction, LEFT)) {
-                    leftLines.push_back(line);
-                } else if (wallDirection == calculateRelativeDirection(direction, RIGHT)) {
-                    rightLines.push_back(line);
-                }
+        if (rightHigher.x - 30 /* TODO: Remove this magic nubmer */ > frontRighter.x) {
+            if (rightHigher.x > 1200 - 120 /* TODO: Remove this magic nubmer */) {
+                model.outerFarRight = rightIndex;
             }
+        }
+    }
 
+    for (size_t leftIndex : model.leftWalls) {
+        const cv::Vec4i& leftLine = walls.lines[leftIndex];
+        cv::Point2f leftHigher = leftLine[1] < leftLine[3] ? cv::Point2f(leftLine[0], leftLine[1]) : cv::Point2f(leftLine[2], leftLine[3]);
 
-            double frontDistance = 0;
-            double outerDistance = 0;
-            double outerFarDistance = -1; // Initialize with a sentinel value -1
+        if (leftHigher.x + 30 /* TODO: Remove this magic nubmer */ < frontLefter.x) {
+            if (leftHigher.x < 120 /* TODO: Remove this magic nubmer */) {
+                model.outerFarLeft = leftIndex;
+            }
+        }
+    }
 
-            if (frontLine != cv::Vec4i(-1.0f, -1.0f, -1.0f, -1.0f)) frontDistance = pointLinePerpendicularDistance(point, frontLine);
-            
-            if (turnDirection == CLOCKWISE) {
-                if (not leftLines.empty()) {
-                    outerDistance = pointLinePerpendicularDistance(point, leftLines[0]);
-                }
-                if ((not rightLines.empty()) && (frontLine != cv::Vec4i(-1.0f, -1.0f, -1.0f, -1.0f))) {
-                    cv::Point2f frontStart(frontLine[0], frontLine[1]);
-                    cv::Point2f frontEnd(frontLine[2], frontLine[3]);
-
-                    cv::Point2f frontLefter;
-                    cv::Point2f frontRighter;
-
-                    if (frontStart.x < frontEnd.x) {
-                        frontLefter = frontStart;
-                        frontRighter = frontEnd;
-                    } else {
-                        frontLefter = frontEnd;
-                        frontRighter = frontStart;
-                    }
+    return model;
+}
 
-                    for (auto rightLine : rightLines) {
-                        cv::Point2f rightStart(rightLine[0], rightLine[1]);
-                        cv::Point2f rightEnd(rightLine[2], rightLine[3]);
+// Keeps the traffic light candidates that are inside the driving lane, away from the front and outer walls
+static std::vector<cv::Point> filterTrafficLightPoints(const std::vector<cv::Point>& candidates, const WallSegments& walls, const WallModel& wallModel, TurnDirection turnDirection) {
+    const int frontWall = wallModel.front;
+    const int outerWall = wallModel.outer(turnDirection);
+    const int outerFarWall = wallModel.outerFar(turnDirection);
 
-                        cv::Point2f rightHigher;
-                        if (rightStart.y < rightEnd.y) {
-                            rightHigher = rightStart;
-                        } else {
-                            rightHigher = rightEnd;
-                        }
+    std::vector<cv::Point> trafficLightPoints;
+    for (const cv::Point& point : candidates) {
+        double frontDistance = frontWall != -1 ? walls.distance(frontWall, point) : 0;
+        double outerDistance = outerWall != -1 ? walls.distance(outerWall, point) : 0;
+        double outerFarDistance = outerFarWall != -1 ? walls.distance(outerFarWall, point) : -1; // Sentinel value -1
 
-                        if (rightHigher.x - 30 /* TODO: Remove this magic nubmer */ > frontRighter.x) {
-                            if (rightHigher.x > 1200 - 120 /* TODO: Remove this magic nubmer */) {
-                                outerFarDistance = pointLinePerpendicularDistance(point, rightLine);
-                            }
-                        }
-                    }
-                }
-            } else if (turnDirection == COUNTER_CLOCKWISE || turnDirection == UNKNOWN) {
-                if (not rightLines.empty()) {
-                    outerDistance = pointLinePerpendicularDistance(point, rightLines[0]);
-                }
-                if ((not leftLines.empty()) && (frontLine != cv::Vec4i(-1.0f, -1.0f, -1.0f, -1.0f))) {
-                    cv::Point2f frontStart(frontLine[0], frontLine[1]);
-                    cv::Point2f frontEnd(frontLine[2], frontLine[3]);
-
-                    cv::Point2f frontLefter;
-                    cv::Point2f frontRighter;
-
-                    if (frontStart.x < frontEnd.x) {
-                        frontLefter = frontStart;
-                        frontRighter = frontEnd;
-                    } else {
-                        frontLefter = frontEnd;
-                        frontRighter = frontStart;
-                    }
+        // Put these thing in the header files
+        const double outerEdge = 40;
+        const double innerEdge = 140;
 
-                    for (auto leftLine : leftLines) {
-                        cv::Point2f leftStart(leftLine[0], leftLine[1]);
-                        cv::Point2f leftEnd(leftLine[2], leftLine[3]);
+        if (outerFarDistance != -1) {
+            if (frontDistance < outerEdge or outerDistance < outerEdge or outerFarDistance < outerEdge) continue;
+            if (frontDistance > innerEdge and outerDistance > innerEdge and outerFarDistance > innerEdge) continue;
+        } else {
+            if (frontDistance < outerEdge or outerDistance < outerEdge) continue;
+            if (frontDistance > innerEdge and outerDistance > innerEdge) continue;
+        }
 
-                        cv::Point2f leftHigher;
-                        if (leftStart.y < leftEnd.y) {
-                            leftHigher = leftStart;
-                        } else {
-                            leftHigher = leftEnd;
-                        }
+        trafficLightPoints.push_back(point);
+    }
 
-                        if (leftHigher.x + 30 /* TODO: Remove this magic nubmer */ < frontLefter.x) {
-                            if (leftHigher.x < 120 /* TODO: Remove this magic nubmer */) {
-                                outerFarDistance = pointLinePerpendicularDistance(point, leftLine);
-                            }
-                        }
-                    }
-                }
-            }
+    return trafficLightPoints;
+}
+
+std::vector<cv::Point> detectTrafficLight(const cv::Mat& binaryImage, const WallSegments& walls, const WallModel& wallModel, TurnDirection turnDirection) {
+    TRACE_SCOPE("detectTrafficLight");
+    cv::Mat dilatedBinaryImage = binaryImage.clone();
+    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(20, 20));
+    cv::dilate(binaryImage, dilatedBinaryImage, kernel);
 
-            // Put these thing in the header files
-            const double outerEdge = 40;
-            const double innerEdge = 140;
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(dilatedBinaryImage, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
 
-            if (outerFarDistance != -1) {
-                if (frontDistance < outerEdge or outerDistance < outerEdge or outerFarDistance < outerEdge) continue;
-                if (frontDistance > innerEdge and outerDistance > innerEdge and outerFarDistance > innerEdge) continue;
-            } else {
-                if (frontDistance < outerEdge or outerDistance < outerEdge) continue;
-                if (frontDistance > innerEdge and outerDistance > innerEdge) continue;
-            }
+    std::vector<cv::Point> candidates;
+    for (const auto& contour : contours) {
+        double area = cv::contourArea(contour);
 
-            trafficLightPoints.push_back(point);
+        if (area >= 300 && area <= 1400) {
+            cv::Moments moments = cv::moments(contour);
+
+            int centroidX = static_cast<int>(moments.m10 / moments.m00);
+            int centroidY = static_cast<int>(moments.m01 / moments.m00);
+
+            candidates.emplace_back(centroidX, centroidY);
         }
     }
 
-    return trafficLightPoints;
+    return filterTrafficLightPoints(candidates, walls, wallModel, turnDirection);
 }
 
-std::vector<cv::Vec4i> detectParkingZone(const cv::Mat& binaryImage, const std::vector<cv::Vec4i>& combinedLines, const std::vector<Direction>& wallDirections, TurnDirection turnDirection, Direction direction) {
+std::vector<cv::Point> detectScanTrafficLight(const std::vector<lidarController::NodeData>& data, int width, int height, float scale, const WallSegments& walls, const WallModel& wallModel, TurnDirection turnDirection) {
+    TRACE_SCOPE("detectScanTrafficLight");
+    return filterTrafficLightPoints(detectScanPillars(data, width, height, scale), walls, wallModel, turnDirection);
+}
+
+std::vector<cv::Point> detectTrafficLight(const cv::Mat& binaryImage, const std::vector<cv::Vec4i>& combinedLines, const std::vector<Direction>& wallDirections, TurnDirection turnDirection, Direction direction) {
+    WallSegments walls(combinedLines);
+    return detectTrafficLight(binaryImage, walls, buildWallModel(walls, wallDirections, direction), turnDirection);
+}
+
+std::vector<cv::Vec4i> detectParkingZone(const cv::Mat& binaryImage, const cv::Rect& roi, const WallSegments& walls, const WallModel& wallModel, TurnDirection turnDirection) {
+    TRACE_SCOPE("detectParkingZone");
     std::vector<cv::Vec4i> lines;
-    cv::HoughLinesP(binaryImage, lines, 1, CV_PI / 180, 20, 30, 30);
+    if (!roi.empty()) {
+        cv::HoughLinesP(binaryImage(roi), lines, 1, CV_PI / 180, 20, 30, 30);
+        offsetLines(lines, roi.tl());
+    }
 
     // Filter lines based on length and proximity to combinedLines
     const double MAX_LENGTH = 60.0;
-    const double MAX_DISTANCE = 10.0; // Distance threshold for proximity
     std::vector<cv::Vec4i> filteredLines;
 
+    const int frontWall = wallModel.front;
+    const int outerWall = wallModel.outer(turnDirection);
+    const int outerFarWall = wallModel.outerFar(turnDirection);
+
     for (const auto& line : lines) {
         // Calculate the length of the line
         double length = std::sqrt(std::pow(line[2] - line[0], 2) + std::pow(line[3] - line[1], 2));
@@ -422,128 +839,12 @@ std::vector<cv::Vec4i> detectParkingZone(const cv::Mat& binaryImage, const std::
         cv::Point p1(line[0], line[1]);
         cv::Point p2(line[2], line[3]);
 
-        cv::Vec4i frontLine(-1.0f, -1.0f, -1.0f, -1.0f);  // Initialize with a sentinel value (-1, -1, -1, -1)
-        std::vector<cv::Vec4i> leftLines;
-        std::vector<cv::Vec4i> rightLines;
-
-        for (size_t i = 0; i < combinedLines.size(); ++i) {
-            cv::Vec4i line = combinedLines[i];
-            Direction wallDirection = wallDirections[i];
-
-            if (wallDirection == calculateRelativeDirection(direction, FRONT)) {
-                if (not(frontLine == cv::Vec4i(-1.0f, -1.0f, -1.0f, -1.0f))) {
-                    cv::Point2f start(line[0], line[1]);
-                    cv::Point2f end(line[2], line[3]);
-                    cv::Point2f newFrontMidPoint = cv::Point2f((start.x + end.x) / 2, (start.y + end.y) / 2);
-
-                    cv::Point2f frontStart(frontLine[0], frontLine[1]);
-                    cv::Point2f frontEnd(frontLine[2], frontLine[3]);
-                    cv::Point2f frontMidPoint = cv::Point2f((frontStart.x + frontEnd.x) / 2, (frontStart.y + frontEnd.y) / 2);
-
-                    if (frontMidPoint.y > newFrontMidPoint.y) {  // Check if new midpoint is higher
-                        frontLine = line;
-                    }
-                } else {
-                    frontLine = line;
-                }
-            } else if (wallDirection == calculateRelativeDirection(direction, LEFT)) {
-                leftLines.push_back(line);
-            } else if (wallDirection == calculateRelativeDirection(direction, RIGHT)) {
-                rightLines.push_back(line);
-            }
-        }
-
-        double frontDistance1 = 0;
-        double frontDistance2 = 0;
-        double outerDistance1 = 0;
-        double outerDistance2 = 0;
-        double outerFarDistance1 = -1;  // Initialize with a sentinel value -1
-        double outerFarDistance2 = -1;  // Initialize with a sentinel value -1
-
-        if (frontLine != cv::Vec4i(-1.0f, -1.0f, -1.0f, -1.0f)) {
-            frontDistance1 = pointLinePerpendicularDistance(p1, frontLine);
-            frontDistance2 = pointLinePerpendicularDistance(p2, frontLine);
-        }
-
-        if (turnDirection == CLOCKWISE) {
-            if (not leftLines.empty()) {
-                outerDistance1 = pointLinePerpendicularDistance(p1, leftLines[0]);
-                outerDistance2 = pointLinePerpendicularDistance(p2, leftLines[0]);
-            }
-            if ((not rightLines.empty()) && (frontLine != cv::Vec4i(-1.0f, -1.0f, -1.0f, -1.0f))) {
-                cv::Point2f frontStart(frontLine[0], frontLine[1]);
-                cv::Point2f frontEnd(frontLine[2], frontLine[3]);
-
-                cv::Point2f frontLefter;
-                cv::Point2f frontRighter;
-
-                if (frontStart.x < frontEnd.x) {
-                    frontLefter = frontStart;
-                    frontRighter = frontEnd;
-                } else {
-                    frontLefter = frontEnd;
-                    frontRighter = frontStart;
-                }
-
-                for (auto rightLine : rightLines) {
-                    cv::Point2f rightStart(rightLine[0], rightLine[1]);
-                    cv::Point2f rightEnd(rightLine[2], rightLine[3]);
-
-                    cv::Point2f rightHigher;
-                    if (rightStart.y < rightEnd.y) {
-                        rightHigher = rightStart;
-                    } else {
-                        rightHigher = rightEnd;
-                    }
-
-                    if (rightHigher.x - 30 /* TODO: Remove this magic nubmer */ > frontRighter.x) {
-                        if (rightHigher.x > 1200 - 120 /* TODO: Remove this magic nubmer */) {
-                            outerFarDistance1 = pointLinePerpendicularDistance(p1, rightLine);
-                            outerFarDistance2 = pointLinePerpendicularDistance(p2, rightLine);
-                        }
-                    }
-                }
-            }
-        } else if (turnDirection == COUNTER_CLOCKWISE || turnDirection == UNKNOWN) {
-            if (not rightLines.empty()) {
-                outerDistance1 = pointLinePerpendicularDistance(p1, rightLines[0]);
-                outerDistance2 = pointLinePerpendicularDistance(p2, rightLines[0]);
-            }
-            if ((not leftLines.empty()) && (frontLine != cv::Vec4i(-1.0f, -1.0f, -1.0f, -1.0f))) {
-                cv::Point2f frontStart(frontLine[0], frontLine[1]);
-                cv::Point2f frontEnd(frontLine[2], frontLine[3]);
-
-                cv::Point2f frontLefter;
-                cv::Point2f frontRighter;
-
-                if (frontStart.x < frontEnd.x) {
-                    frontLefter = frontStart;
-                    frontRighter = frontEnd;
-                } else {
-                    frontLefter = frontEnd;
-                    frontRighter = frontStart;
-                }
-
-                for (auto leftLine : leftLines) {
-                    cv::Point2f leftStart(leftLine[0], leftLine[1]);
-                    cv::Point2f leftEnd(leftLine[2], leftLine[3]);
-
-                    cv::Point2f leftHigher;
-                    if (leftStart.y < leftEnd.y) {
-                        leftHigher = leftStart;
-                    } else {
-                        leftHigher = leftEnd;
-                    }
-
-                    if (leftHigher.x + 30 /* TODO: Remove this magic nubmer */ < frontLefter.x) {
-                        if (leftHigher.x < 120 /* TODO: Remove this magic nubmer */) {
-                            outerFarDistance1 = pointLinePerpendicularDistance(p1, leftLine);
-                            outerFarDistance2 = pointLinePerpendicularDistance(p2, leftLine);
-                        }
-                    }
-                }
-            }
-        }
+        double frontDistance1 = frontWall != -1 ? walls.distance(frontWall, p1) : 0;
+        double frontDistance2 = frontWall != -1 ? walls.distance(frontWall, p2) : 0;
+        double outerDistance1 = outerWall != -1 ? walls.distance(outerWall, p1) : 0;
+        double outerDistance2 = outerWall != -1 ? walls.distance(outerWall, p2) : 0;
+        double outerFarDistance1 = outerFarWall != -1 ? walls.distance(outerFarWall, p1) : -1;  // Sentinel value -1
+        double outerFarDistance2 = outerFarWall != -1 ? walls.distance(outerFarWall, p2) : -1;  // Sentinel value -1
 
         // Put these thing in the header files
         const double frontOuterEdge = 40;
@@ -577,11 +878,21 @@ std::vector<cv::Vec4i> detectParkingZone(const cv::Mat& binaryImage, const std::
     return filteredLines;
 }
 
+std::vector<cv::Vec4i> detectParkingZone(const cv::Mat& binaryImage, const WallSegments& walls, const WallModel& wallModel, TurnDirection turnDirection) {
+    return detectParkingZone(binaryImage, cv::Rect(0, 0, binaryImage.cols, binaryImage.rows), walls, wallModel, turnDirection);
+}
+
+std::vector<cv::Vec4i> detectParkingZone(const cv::Mat& binaryImage, const std::vector<cv::Vec4i>& combinedLines, const std::vector<Direction>& wallDirections, TurnDirection turnDirection, Direction direction) {
+    WallSegments walls(combinedLines);
+    return detectParkingZone(binaryImage, walls, buildWallModel(walls, wallDirections, direction), turnDirection);
+}
+
 std::vector<ProcessedTrafficLight> processTrafficLight(
     const std::vector<cv::Point>& trafficLightPoints, 
     const std::vector<BlockInfo>& blockInfos,
     const cv::Point& center
 ) {
+    TRACE_SCOPE("processTrafficLight");
     constexpr int BLOCK_SIZE_TO_PRIORITIZE_DISTANCE = 3000;
     constexpr int MIN_BLOCK_SIZE = 0;
     constexpr float MAX_LIDAR_CAM_ANGLE_DIFFERENCE = 8.0f;
@@ -640,40 +951,12 @@ std::vector<ProcessedTrafficLight> processTrafficLight(
 }
 
 
-TurnDirection lidarDetectTurnDirection(const std::vector<cv::Vec4i>& combinedLines, const std::vector<Direction>& wallDirections, Direction direction) {
-    cv::Vec4i frontLine(-1.0f, -1.0f, -1.0f, -1.0f); // Initialize with a sentinel value (-1, -1, -1, -1)
-    std::vector<cv::Vec4i> leftLines;
-    std::vector<cv::Vec4i> rightLines;
+TurnDirection lidarDetectTurnDirection(const WallSegments& walls, const WallModel& wallModel) {
+    TRACE_SCOPE("lidarDetectTurnDirection");
+    if (wallModel.front == -1) return TurnDirection::UNKNOWN;
+    if (wallModel.leftWalls.empty() && wallModel.rightWalls.empty()) return TurnDirection::UNKNOWN;
 
-    for (size_t i = 0; i < combinedLines.size(); ++i) {
-        cv::Vec4i line = combinedLines[i];
-        Direction wallDirection = wallDirections[i];
-
-        if (wallDirection == calculateRelativeDirection(direction, FRONT)) {
-            if (not (frontLine == cv::Vec4i(-1.0f, -1.0f, -1.0f, -1.0f))) {
-                cv::Point2f start(line[0], line[1]);
-                cv::Point2f end(line[2], line[3]);
-                cv::Point2f newFrontMidPoint = cv::Point2f((start.x + end.x) / 2, (start.y + end.y) / 2);
-
-                cv::Point2f frontStart(frontLine[0], frontLine[1]);
-                cv::Point2f frontEnd(frontLine[2], frontLine[3]);
-                cv::Point2f frontMidPoint = cv::Point2f((frontStart.x + frontEnd.x) / 2, (frontStart.y + frontEnd.y) / 2);
-
-                if (frontMidPoint.y > newFrontMidPoint.y) { // Check if new midpoint is higher
-                    frontLine = line;
-                }
-            } else {
-                frontLine = line;
-            }
-        } else if (wallDirection == calculateRelativeDirection(direction, LEFT)) {
-            leftLines.push_back(line);
-        } else if (wallDirection == calculateRelativeDirection(direction, RIGHT)) {
-            rightLines.push_back(line);
-        }
-    }
-
-    if (frontLine == cv::Vec4i(-1.0f, -1.0f, -1.0f, -1.0f)) return TurnDirection::UNKNOWN;
-    if (leftLines.empty() && rightLines.empty()) return TurnDirection::UNKNOWN;
+    const cv::Vec4i& frontLine = walls.lines[wallModel.front];
 
     cv::Point2f frontStart(frontLine[0], frontLine[1]);
     cv::Point2f frontEnd(frontLine[2], frontLine[3]);
@@ -689,7 +972,8 @@ TurnDirection lidarDetectTurnDirection(const std::vector<cv::Vec4i>& combinedLin
         frontRighter = frontStart;
     }
 
-    for (auto leftLine : leftLines) {
+    for (size_t leftIndex : wallModel.leftWalls) {
+        const cv::Vec4i& leftLine = walls.lines[leftIndex];
         cv::Point2f leftStart(leftLine[0], leftLine[1]);
         cv::Point2f leftEnd(leftLine[2], leftLine[3]);
 
@@ -709,7 +993,8 @@ TurnDirection lidarDetectTurnDirection(const std::vector<cv::Vec4i>& combinedLin
         if (leftHigher.x - 40 /* TODO: Remove this magic nubmer */ > frontLefter.x) return TurnDirection::COUNTER_CLOCKWISE;
     }
 
-    for (auto rightLine : rightLines) {
+    for (size_t rightIndex : wallModel.rightWalls) {
+        const cv::Vec4i& rightLine = walls.lines[rightIndex];
         cv::Point2f rightStart(rightLine[0], rightLine[1]);
         cv::Point2f rightEnd(rightLine[2], rightLine[3]);
 
@@ -732,6 +1017,11 @@ TurnDirection lidarDetectTurnDirection(const std::vector<cv::Vec4i>& combinedLin
     return TurnDirection::UNKNOWN;
 }
 
+TurnDirection lidarDetectTurnDirection(const std::vector<cv::Vec4i>& combinedLines, const std::vector<Direction>& wallDirections, Direction direction) {
+    WallSegments walls(combinedLines);
+    return lidarDetectTurnDirection(walls, buildWallModel(walls, wallDirections, direction));
+}
+
 
 void drawAllLines(cv::Mat &outputImage, const std::vector<cv::Vec4i> &lines, const std::vector<Direction> &wallDirections) {
     for (size_t i = 0; i < lines.size(); ++i) {
@@ -1,6 +1,7 @@
 #ifndef LIDAR_DATA_PROCESSOR_H
 #define LIDAR_DATA_PROCESSOR_H
 
+#include <cmath>
 #include <opencv2/opencv.hpp>
 #include <vector>
 
@@ -21,14 +22,81 @@ struct ProcessedTrafficLight {
     Color color;  // Color of the traffic light
 };
 
+// Geometry of the wall segments of one frame, computed once and shared by the perception stages instead of
+// being recomputed from the endpoints by every call. Stored as a structure of arrays, entry i describes lines[i].
+struct WallSegments {
+    std::vector<cv::Vec4i> lines;
+    std::vector<cv::Point2f> direction;  // Unit vector from start to end
+    std::vector<cv::Point2f> normal;     // Unit vector perpendicular to the line, (-direction.y, direction.x)
+    std::vector<float> length;           // Same as lineLength
+    std::vector<float> angle;            // Same as calculateAngle, in degrees [0, 180]
+    std::vector<float> normalAngle;      // Angle of normal in degrees (-180, 180]
+    std::vector<float> offset;           // normal . start, signed distance of the line from the origin
+
+    WallSegments() = default;
+    explicit WallSegments(const std::vector<cv::Vec4i>& segments) { assign(segments); }
+
+    // Recomputes the geometry for segments, reusing the storage
+    void assign(const std::vector<cv::Vec4i>& segments);
+
+    size_t size() const { return lines.size(); }
+    bool empty() const { return lines.empty(); }
+
+    // Same as pointLinePerpendicularDistance(pt, lines[i])
+    float distance(size_t i, const cv::Point2f& pt) const {
+        return std::abs(normal[i].x * pt.x + normal[i].y * pt.y - offset[i]);
+    }
+
+    // Same as pointLinePerpendicularDirection(pt, lines[i])
+    float perpendicularDirection(size_t i, const cv::Point2f& pt) const {
+        float side = normal[i].x * pt.x + normal[i].y * pt.y - offset[i];
+        return std::fmod(normalAngle[i] + (side < 0 ? 180.0f : 0.0f) + 360.0f, 360.0f);
+    }
+};
+
+// Walls of one frame grouped by their side relative to the robot heading. Built once per frame by buildWallModel
+// and shared by the detectors, all entries are indices into the WallSegments the model was built from.
+struct WallModel {
+    std::vector<size_t> frontWalls;  // In the order of the segments
+    std::vector<size_t> leftWalls;
+    std::vector<size_t> rightWalls;
+    int front = -1;          // Front wall with the highest midpoint, -1 if there is none
+    int outerFarRight = -1;  // Right wall beyond the corner ahead, -1 if there is none
+    int outerFarLeft = -1;   // Left wall beyond the corner ahead, -1 if there is none
+
+    // Outer wall while driving in turnDirection, -1 if there is none
+    int outer(TurnDirection turnDirection) const {
+        const auto& walls = turnDirection == CLOCKWISE ? leftWalls : rightWalls;
+        return walls.empty() ? -1 : static_cast<int>(walls[0]);
+    }
+
+    // Outer wall past the next corner while driving in turnDirection, -1 if there is none
+    int outerFar(TurnDirection turnDirection) const {
+        return turnDirection == CLOCKWISE ? outerFarRight : outerFarLeft;
+    }
+};
+
 // Converts LIDAR data to a grayscale OpenCV image for Hough Line detection
 cv::Mat lidarDataToImage(const std::vector<lidarController::NodeData> &data, int width, int height, float scale);
+// Same for count points that are not in a vector, e.g. a scan viewed in a memory-mapped log
+cv::Mat lidarDataToImage(const lidarController::NodeData *data, size_t count, int width, int height, float scale);
 
 float toMeter(int scale, double lidarDistance);
 
 // Detects lines using the Hough Transform
 std::vector<cv::Vec4i> detectLines(const cv::Mat &binaryImage);
 
+// Same as detectLines, but only searches roi of the image (see LidarRasterizer). Lines are in full image coordinates.
+std::vector<cv::Vec4i> detectLines(const cv::Mat &binaryImage, const cv::Rect &roi);
+
+// Detects lines directly from the ordered scan points (split-and-merge), without rasterizing them.
+// Returns segments in the same image coordinates as lidarDataToImage + detectLines.
+std::vector<cv::Vec4i> detectScanLines(const std::vector<lidarController::NodeData> &data, int width, int height, float scale);
+
+// Finds pillar sized clusters directly in the ordered scan points (jump distance segmentation), without rasterizing
+// and dilating them. Returns the cluster centroids in the same image coordinates as lidarDataToImage.
+std::vector<cv::Point> detectScanPillars(const std::vector<lidarController::NodeData> &data, int width, int height, float scale);
+
 double lineLength(const cv::Vec4i& line);
 
 // Calculates the angle of a line in degrees
@@ -46,14 +114,29 @@ cv::Vec4i extendLine(const cv::Vec4i& line, double factor);
 // Checks if two lines are aligned and collinear within specified thresholds
 bool areLinesAligned(const cv::Vec4i& line1, const cv::Vec4i& line2, double angleThreshold, double collinearThreshold);
 
-// Combines aligned and collinear lines into single lines
+// Combines aligned and collinear lines into single lines.
+// Gives the same result as combineAlignedLinesExhaustive, but lines are indexed by angle and offset so each line is
+// only compared with the candidates that can reach it, which keeps it near-linear in the number of lines.
 std::vector<cv::Vec4i> combineAlignedLines(std::vector<cv::Vec4i> lines, double angleThreshold = 12.0, double collinearThreshold = 10.0);
 
+// Reference version of combineAlignedLines that compares every pair of lines until nothing merges (quadratic per round)
+std::vector<cv::Vec4i> combineAlignedLinesExhaustive(std::vector<cv::Vec4i> lines, double angleThreshold = 12.0, double collinearThreshold = 10.0);
+
 // Function to analyze the combined lines with gyro data and classify them as NORTH, EAST, SOUTH, WEST
+std::vector<Direction> analyzeWallDirection(const WallSegments& walls, float gyroYaw, const cv::Point& center);
 std::vector<Direction> analyzeWallDirection(const std::vector<cv::Vec4i>& combinedLines, float gyroYaw, const cv::Point& center);
 
+// Groups the walls into front, left and right for a robot heading in direction
+WallModel buildWallModel(const WallSegments& walls, const std::vector<Direction>& wallDirections, Direction direction);
+
+std::vector<cv::Point> detectTrafficLight(const cv::Mat& binaryImage, const WallSegments& walls, const WallModel& wallModel, TurnDirection turnDirection);
 std::vector<cv::Point> detectTrafficLight(const cv::Mat& binaryImage, const std::vector<cv::Vec4i>& combinedLines, const std::vector<Direction>& wallDirections, TurnDirection turnDirection, Direction direction);
 
+// Same as detectTrafficLight, but takes the candidates from detectScanPillars instead of the binary image
+std::vector<cv::Point> detectScanTrafficLight(const std::vector<lidarController::NodeData>& data, int width, int height, float scale, const WallSegments& walls, const WallModel& wallModel, TurnDirection turnDirection);
+
+std::vector<cv::Vec4i> detectParkingZone(const cv::Mat& binaryImage, const cv::Rect& roi, const WallSegments& walls, const WallModel& wallModel, TurnDirection turnDirection);
+std::vector<cv::Vec4i> detectParkingZone(const cv::Mat& binaryImage, const WallSegments& walls, const WallModel& wallModel, TurnDirection turnDirection);
 std::vector<cv::Vec4i> detectParkingZone(const cv::Mat& binaryImage, const std::vector<cv::Vec4i>& combinedLines, const std::vector<Direction>& wallDirections, TurnDirection turnDirection, Direction direction);
 
 std::vector<ProcessedTrafficLight> processTrafficLight(
@@ -62,6 +145,7 @@ std::vector<ProcessedTrafficLight> processTrafficLight(
     const cv::Point& center
 );
 
+TurnDirection lidarDetectTurnDirection(const WallSegments& walls, const WallModel& wallModel);
 TurnDirection lidarDetectTurnDirection(const std::vector<cv::Vec4i>& combinedLines, const std::vector<Direction>& wallDirections, Direction direction);
 
 float toMeter(int scale, double lidarDistance);
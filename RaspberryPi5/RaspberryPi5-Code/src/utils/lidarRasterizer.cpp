@@ -0,0 +1,60 @@
+#include "lidarRasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "trace.h"
+
+LidarRasterizer::LidarRasterizer(int width, int height, float scale)
+    : scale(scale), mapImage(cv::Mat::zeros(height, width, CV_8UC1)) {
+}
+
+const cv::Mat& LidarRasterizer::rasterize(const std::vector<lidarController::NodeData>& data) {
+    TRACE_SCOPE("LidarRasterizer::rasterize");
+    const int width = mapImage.cols;
+    const int height = mapImage.rows;
+    cv::Point center(width / 2, height / 2);
+
+    // Same filters and projection as lidarDataToImage
+    dots.clear();
+    int minX = width, minY = height, maxX = -1, maxY = -1;
+    for (const auto& point : data) {
+        if (point.distance < 0.005)
+            continue;
+        if (point.distance > 3.200)
+            continue;
+        if (point.angle > 5 && point.angle < 175 && point.distance > 0.700)
+            continue;
+
+        float angle_rad = point.angle * CV_PI / 180.0;
+        int x = static_cast<int>(center.x + point.distance * scale * cos(angle_rad));
+        int y = static_cast<int>(center.y + point.distance * scale * sin(angle_rad));
+
+        int radius = static_cast<int>(std::max(1.0, point.distance * scale * 0.011));
+
+        if (x >= 0 && x < width && y >= 0 && y < height) {
+            dots.push_back({cv::Point(x, y), radius});
+            minX = std::min(minX, x - radius);
+            minY = std::min(minY, y - radius);
+            maxX = std::max(maxX, x + radius);
+            maxY = std::max(maxY, y + radius);
+        }
+    }
+
+    // Only the previous points can be non-zero
+    if (!occupiedRoi.empty()) {
+        mapImage(occupiedRoi).setTo(0);
+    }
+
+    if (dots.empty()) {
+        occupiedRoi = cv::Rect();
+        return mapImage;
+    }
+
+    occupiedRoi = cv::Rect(cv::Point(minX, minY), cv::Point(maxX + 1, maxY + 1)) & cv::Rect(0, 0, width, height);
+    for (const auto& dot : dots) {
+        cv::circle(mapImage, dot.center, dot.radius, cv::Scalar(255), -1);
+    }
+
+    return mapImage;
+}
@@ -0,0 +1,55 @@
+#ifndef LIDAR_RASTERIZER_H
+#define LIDAR_RASTERIZER_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "lidarController.h"
+
+/**
+ * @brief Rasterizes scans like lidarDataToImage into an image that is reused across frames.
+ *
+ * The filters of lidarDataToImage drop everything beyond 3.2 m and the sides beyond 0.7 m,
+ * so the points only cover part of the map. Each frame only the region of interest of the
+ * previous frame is cleared and the new points are drawn, so the cost follows the occupied
+ * area instead of the full width x height. Stages that accept a region of interest (detectLines,
+ * detectParkingZone) only look at roi() and shift their results back into map coordinates.
+ */
+class LidarRasterizer {
+public:
+    LidarRasterizer(int width, int height, float scale);
+
+    /**
+     * @brief Draws data into the persistent image, replacing the previous scan.
+     * @return The full map image, zero outside roi(). Valid until the next call.
+     */
+    const cv::Mat& rasterize(const std::vector<lidarController::NodeData>& data);
+
+    /**
+     * @brief Full width x height map image of the last scan.
+     */
+    const cv::Mat& image() const { return mapImage; }
+
+    /**
+     * @brief Tight bounding box of the drawn points in map coordinates, empty if nothing was drawn.
+     */
+    const cv::Rect& roi() const { return occupiedRoi; }
+
+    /**
+     * @brief View of the occupied part of image(), its (0, 0) is roi().tl() in the map.
+     */
+    cv::Mat roiImage() const { return mapImage(occupiedRoi); }
+
+private:
+    struct Dot {
+        cv::Point center;
+        int radius;
+    };
+
+    float scale;
+    cv::Mat mapImage;
+    cv::Rect occupiedRoi;
+    std::vector<Dot> dots;  // Kept to reuse the allocation
+};
+
+#endif // LIDAR_RASTERIZER_H
@@ -1,6 +1,10 @@
 #ifndef LIDAR_STRUCT_H
 #define LIDAR_STRUCT_H
 
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
 namespace lidarController {
 
 /**
@@ -12,6 +16,15 @@ namespace lidarController {
     float distance;
   };
 
+  /**
+   * One complete LIDAR rotation as published by the streaming mode of LidarController.
+   */
+  struct LidarScan {
+    std::vector<NodeData> nodes;
+    uint64_t sequence = 0;  ///< Increments with every published scan, 0 means no scan has arrived yet.
+    std::chrono::steady_clock::time_point timestamp;  ///< When the rotation finished.
+  };
+
 }
 
-#endif  // LIDAR_STRUCT_H
\ No newline at end of file
+#endif  // LIDAR_STRUCT_H
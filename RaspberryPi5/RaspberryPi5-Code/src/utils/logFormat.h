@@ -0,0 +1,100 @@
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <cstdint>
+
+#include "lidar_struct.h"
+#include "bno055_struct.h"
+
+/*
+ * On-disk layout of the run logs written by DataSaver (version 1).
+ *
+ *   LogFileHeader
+ *   record 0: LogRecordHeader | NodeData[scanCount] | image bytes | zero padding to 8 bytes
+ *   record 1: ...
+ *   LogIndexHeader | LogIndexEntry[recordCount] | LogFileTrailer
+ *
+ * Every block starts on an 8 byte boundary so NodeData can be read in place from a mapping.
+ * The index and trailer are only written when a LogWriter is closed cleanly; readers rebuild
+ * the index by walking the records when the trailer is missing (e.g. after a power cut).
+ *
+ * Files that do not start with LOG_FILE_MAGIC are the legacy format: a bare sequence of
+ * size_t scan count | NodeData[] | accel | euler | size_t PNG size | PNG bytes.
+ */
+namespace DataSaver {
+
+constexpr char LOG_FILE_MAGIC[8] = {'K', 'M', 'I', 'D', 'S', 'L', 'O', 'G'};
+constexpr uint32_t LOG_FORMAT_VERSION = 1;
+
+constexpr uint32_t LOG_RECORD_MAGIC = 0x44524352;  // "RCRD"
+constexpr uint32_t LOG_INDEX_MAGIC = 0x58444E49;   // "INDX"
+constexpr uint32_t LOG_TRAILER_MAGIC = 0x4C494154; // "TAIL"
+
+constexpr uint64_t LOG_ALIGNMENT = 8;
+
+enum class LogImageEncoding : uint32_t {
+    NONE = 0,
+    PNG = 1,
+    RAW = 2,    // Rows of imageCols * elemSize bytes, no compression
+    JPEG = 3,
+    DELTA = 4,  // uint64_t keyframe record offset, then a PNG of the XOR against that keyframe's image
+};
+
+struct LogFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;  // sizeof(LogFileHeader), lets later versions grow the header
+};
+
+struct LogRecordHeader {
+    uint32_t magic;
+    uint32_t scanCount;
+    int64_t timestampUs;  // steady clock capture time in microseconds
+    bno055_accel_float_t accel;
+    bno055_euler_float_t euler;
+    uint32_t imageEncoding;  // LogImageEncoding
+    int32_t imageRows;
+    int32_t imageCols;
+    int32_t imageType;
+    uint64_t imageSize;  // Encoded image bytes, without padding
+};
+
+struct LogIndexHeader {
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t recordCount;
+};
+
+struct LogIndexEntry {
+    uint64_t offset;  // File offset of the LogRecordHeader
+    int64_t timestampUs;
+};
+
+struct LogFileTrailer {
+    uint64_t indexOffset;  // File offset of the LogIndexHeader
+    uint64_t recordCount;
+    uint32_t magic;
+    uint32_t version;
+};
+
+static_assert(sizeof(LogFileHeader) == 16, "LogFileHeader layout changed");
+static_assert(sizeof(LogRecordHeader) == 64, "LogRecordHeader layout changed");
+static_assert(sizeof(LogIndexHeader) == 16, "LogIndexHeader layout changed");
+static_assert(sizeof(LogIndexEntry) == 16, "LogIndexEntry layout changed");
+static_assert(sizeof(LogFileTrailer) == 24, "LogFileTrailer layout changed");
+static_assert(sizeof(lidarController::NodeData) == 8, "NodeData layout changed");
+
+// Bytes of zero padding needed after a block of the given size
+inline uint64_t logPadding(uint64_t size) {
+    return (LOG_ALIGNMENT - size % LOG_ALIGNMENT) % LOG_ALIGNMENT;
+}
+
+// Total size of a record including its header and padding
+inline uint64_t logRecordSize(const LogRecordHeader& header) {
+    uint64_t size = sizeof(LogRecordHeader) + uint64_t(header.scanCount) * sizeof(lidarController::NodeData) + header.imageSize;
+    return size + logPadding(size);
+}
+
+}  // namespace DataSaver
+
+#endif  // LOG_FORMAT_H
@@ -0,0 +1,141 @@
+#include "logMappedReader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iostream>
+
+#include "dataSaver.h"
+
+namespace DataSaver {
+
+LogMappedReader::LogMappedReader(size_t imageCacheSize) : imageCacheSize(imageCacheSize > 0 ? imageCacheSize : 1) {}
+
+LogMappedReader::~LogMappedReader() {
+    close();
+}
+
+LogMappedReader::OpenStatus LogMappedReader::open(const std::string& filePath) {
+    close();
+
+    // Reuse LogReader for the footer index or the record walk
+    {
+        LogReader indexReader;
+        if (!indexReader.open(filePath)) {
+            return OpenStatus::FAILED;
+        }
+        // Legacy records are not aligned and cannot be mapped, the caller decides whether to fall back
+        if (indexReader.version() == 0) {
+            return OpenStatus::LEGACY;
+        }
+        index = indexReader.recordIndex();
+    }
+
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Failed to open file for mapping log data: " << filePath << std::endl;
+        index.clear();
+        return OpenStatus::FAILED;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) < 0 || fileStat.st_size == 0) {
+        std::cerr << "Failed to get size of log file: " << filePath << std::endl;
+        ::close(fd);
+        index.clear();
+        return OpenStatus::FAILED;
+    }
+
+    void* address = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // The mapping keeps the file alive
+    if (address == MAP_FAILED) {
+        std::cerr << "Failed to map log file: " << filePath << std::endl;
+        index.clear();
+        return OpenStatus::FAILED;
+    }
+    mapping = static_cast<const uint8_t*>(address);
+    mappingSize = fileStat.st_size;
+
+    // Check every record once so record() can hand out views without checks
+    for (size_t i = 0; i < index.size(); ++i) {
+        uint64_t offset = index[i].offset;
+        if (offset % LOG_ALIGNMENT != 0 || offset + sizeof(LogRecordHeader) > mappingSize
+            || recordHeader(i).magic != LOG_RECORD_MAGIC || offset + logRecordSize(recordHeader(i)) > mappingSize) {
+            std::cerr << "Corrupt log record " << i << ", ignoring the rest of the file." << std::endl;
+            index.resize(i);
+            break;
+        }
+    }
+
+    return OpenStatus::OK;
+}
+
+void LogMappedReader::close() {
+    if (mapping) {
+        munmap(const_cast<uint8_t*>(mapping), mappingSize);
+        mapping = nullptr;
+        mappingSize = 0;
+    }
+    index.clear();
+    imageCache.clear();
+    imageCacheLookup.clear();
+}
+
+const LogRecordHeader& LogMappedReader::recordHeader(size_t recordIndex) const {
+    return *reinterpret_cast<const LogRecordHeader*>(mapping + index[recordIndex].offset);
+}
+
+LogRecordView LogMappedReader::record(size_t recordIndex) const {
+    const LogRecordHeader& header = recordHeader(recordIndex);
+
+    LogRecordView view;
+    view.timestampUs = header.timestampUs;
+    view.scanData.data = reinterpret_cast<const lidarController::NodeData*>(&header + 1);
+    view.scanData.count = header.scanCount;
+    view.accel_data = header.accel;
+    view.euler_data = header.euler;
+    return view;
+}
+
+cv::Mat LogMappedReader::image(size_t recordIndex) {
+    auto cached = imageCacheLookup.find(recordIndex);
+    if (cached != imageCacheLookup.end()) {
+        imageCache.splice(imageCache.begin(), imageCache, cached->second);
+        return cached->second->second;
+    }
+
+    const LogRecordHeader& header = recordHeader(recordIndex);
+    const uchar* imageData = reinterpret_cast<const uchar*>(&header + 1) + header.scanCount * sizeof(lidarController::NodeData);
+
+    auto keyframeLoader = [this](uint64_t offset, cv::Mat& keyframe) {
+        // The keyframe is an earlier record, find it by offset and decode it through the cache
+        auto it = std::lower_bound(index.begin(), index.end(), offset,
+                                   [](const LogIndexEntry& entry, uint64_t value) { return entry.offset < value; });
+        if (it == index.end() || it->offset != offset) return false;
+
+        size_t keyframeIndex = static_cast<size_t>(it - index.begin());
+        if (recordHeader(keyframeIndex).imageEncoding == static_cast<uint32_t>(LogImageEncoding::DELTA)) return false;
+
+        keyframe = image(keyframeIndex);
+        return !keyframe.empty();
+    };
+
+    cv::Mat decoded;
+    if (!decodeLogImage(header, imageData, decoded, keyframeLoader)) {
+        std::cerr << "Failed to decode image of record " << recordIndex << "." << std::endl;
+        return cv::Mat();
+    }
+
+    if (imageCache.size() >= imageCacheSize) {
+        imageCacheLookup.erase(imageCache.back().first);
+        imageCache.pop_back();
+    }
+    imageCache.emplace_front(recordIndex, decoded);
+    imageCacheLookup[recordIndex] = imageCache.begin();
+
+    return decoded;
+}
+
+}  // namespace DataSaver
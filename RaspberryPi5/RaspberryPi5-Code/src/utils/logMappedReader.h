@@ -0,0 +1,99 @@
+#ifndef LOG_MAPPED_READER_H
+#define LOG_MAPPED_READER_H
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "logFormat.h"
+
+namespace DataSaver {
+
+/**
+ * @brief Read-only view of the NodeData of one scan, pointing into the mapped file.
+ */
+struct NodeDataView {
+    const lidarController::NodeData* data = nullptr;
+    size_t count = 0;
+
+    const lidarController::NodeData* begin() const { return data; }
+    const lidarController::NodeData* end() const { return data + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const lidarController::NodeData& operator[](size_t i) const { return data[i]; }
+};
+
+/**
+ * @brief One record of a mapped log. Valid until the reader is closed.
+ */
+struct LogRecordView {
+    int64_t timestampUs;
+    NodeDataView scanData;
+    bno055_accel_float_t accel_data;
+    bno055_euler_float_t euler_data;
+};
+
+/**
+ * @brief Memory-mapped reader for version 1 log files.
+ *
+ * Scans are returned as views straight into the mapping, so nothing is copied and the
+ * kernel only pages in the records that are touched. Camera images are decoded on
+ * access and the most recent ones are kept in a small LRU cache.
+ * Legacy files cannot be mapped (their records are not aligned), use LogReader for them.
+ */
+class LogMappedReader {
+public:
+    enum class OpenStatus {
+        OK,
+        LEGACY,     // Valid legacy log, read it with LogReader instead. Nothing is printed.
+        FAILED,     // Cannot be opened or is corrupt, the reason was printed
+    };
+
+    /**
+     * @param imageCacheSize Number of decoded camera images to keep.
+     */
+    explicit LogMappedReader(size_t imageCacheSize = 8);
+    ~LogMappedReader();
+
+    LogMappedReader(const LogMappedReader&) = delete;
+    LogMappedReader& operator=(const LogMappedReader&) = delete;
+
+    /**
+     * @brief Maps a log file and loads or rebuilds its frame index.
+     * @return OK once mapped, LEGACY for a valid file that is not a version 1 log, FAILED otherwise.
+     */
+    OpenStatus open(const std::string& filePath);
+
+    void close();
+
+    size_t recordCount() const { return index.size(); }
+
+    /**
+     * @brief Returns a zero-copy view of one record. The index must be below recordCount().
+     */
+    LogRecordView record(size_t recordIndex) const;
+
+    /**
+     * @brief Decodes the camera image of one record, or returns it from the cache.
+     * @return The image, empty if the record has none or decoding failed.
+     */
+    cv::Mat image(size_t recordIndex);
+
+private:
+    const LogRecordHeader& recordHeader(size_t recordIndex) const;
+
+    const uint8_t* mapping = nullptr;
+    size_t mappingSize = 0;
+    std::vector<LogIndexEntry> index;
+
+    size_t imageCacheSize;
+    std::list<std::pair<size_t, cv::Mat>> imageCache;  ///< Most recently used first.
+    std::unordered_map<size_t, std::list<std::pair<size_t, cv::Mat>>::iterator> imageCacheLookup;
+};
+
+}  // namespace DataSaver
+
+#endif  // LOG_MAPPED_READER_H
@@ -0,0 +1,102 @@
+#include "rateScheduler.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+static int64_t monotonicNs() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+RateScheduler::RateScheduler(double rateHz) : periodNs(static_cast<int64_t>(1e9 / rateHz)) {
+    start();
+}
+
+void RateScheduler::start() {
+    startNs = monotonicNs();
+    deadlineNs = startNs;
+}
+
+int RateScheduler::waitNext() {
+    deadlineNs += periodNs;
+    int periods = 1;
+
+    int64_t now = monotonicNs();
+    if (now > deadlineNs) {
+        // The step ran past its slot, continue with the next deadline that is still ahead
+        int64_t missed = (now - deadlineNs) / periodNs + 1;
+        deadlineNs += missed * periodNs;
+        periods += missed;
+        overruns++;
+        missedDeadlines += missed;
+    }
+
+    timespec deadline;
+    deadline.tv_sec = deadlineNs / 1000000000;
+    deadline.tv_nsec = deadlineNs % 1000000000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+    }
+
+    int64_t latenessNs = monotonicNs() - deadlineNs;
+    size_t bucket = 0;
+    while (bucket < LATENESS_BUCKET_US.size() && latenessNs >= LATENESS_BUCKET_US[bucket] * 1000) {
+        bucket++;
+    }
+    latenessHistogram[bucket]++;
+    totalLatenessNs += latenessNs;
+    if (latenessNs > maxLatenessNs) maxLatenessNs = latenessNs;
+    steps++;
+
+    return periods;
+}
+
+void RateScheduler::printStats(std::ostream& out) const {
+    char line[160];
+    snprintf(line, sizeof(line), "Rate %.1f Hz: %llu steps, %llu overruns, %llu missed deadlines\n",
+             1e9 / periodNs, static_cast<unsigned long long>(steps), static_cast<unsigned long long>(overruns),
+             static_cast<unsigned long long>(missedDeadlines));
+    out << line;
+    if (steps == 0) return;
+
+    snprintf(line, sizeof(line), "Wake-up lateness: mean %.1f us, max %.1f us\n", totalLatenessNs / steps / 1e3, maxLatenessNs / 1e3);
+    out << line;
+    for (size_t i = 0; i < latenessHistogram.size(); ++i) {
+        if (i < LATENESS_BUCKET_US.size()) {
+            snprintf(line, sizeof(line), "  < %5lld us %10llu\n", static_cast<long long>(LATENESS_BUCKET_US[i]),
+                     static_cast<unsigned long long>(latenessHistogram[i]));
+        } else {
+            snprintf(line, sizeof(line), " >= %5lld us %10llu\n", static_cast<long long>(LATENESS_BUCKET_US.back()),
+                     static_cast<unsigned long long>(latenessHistogram[i]));
+        }
+        out << line;
+    }
+}
+
+bool RateScheduler::setRealtimePriority(int priority) {
+    sched_param param{};
+    param.sched_priority = priority;
+    int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (result != 0) {
+        std::cerr << "Failed to set SCHED_FIFO priority " << priority << ": " << std::strerror(result) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool RateScheduler::pinToCpu(int cpu) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (result != 0) {
+        std::cerr << "Failed to pin thread to CPU " << cpu << ": " << std::strerror(result) << std::endl;
+        return false;
+    }
+    return true;
+}
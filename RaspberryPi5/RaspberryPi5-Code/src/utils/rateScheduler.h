@@ -0,0 +1,80 @@
+#ifndef RATE_SCHEDULER_H
+#define RATE_SCHEDULER_H
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * Runs a loop at a fixed rate on absolute deadlines.
+ *
+ *   RateScheduler scheduler(50.0);
+ *   while (running) {
+ *       scheduler.waitNext();
+ *       step(scheduler.periodSeconds());
+ *   }
+ *
+ * waitNext sleeps with clock_nanosleep(TIMER_ABSTIME) on CLOCK_MONOTONIC, the steady_clock timeline,
+ * so sleep errors never add up. A step that runs past the next deadline is an overrun. The missed
+ * deadlines are skipped rather than run back to back, and the loop continues on the original grid.
+ * Every wake-up records how late it was against its deadline in a histogram.
+ */
+class RateScheduler {
+public:
+    explicit RateScheduler(double rateHz);
+
+    /**
+     * @brief Restarts the deadline grid from now, e.g. right before the loop after a long setup.
+     */
+    void start();
+
+    /**
+     * @brief Sleeps until the next deadline.
+     * @return Periods since the previous step, 1 unless the previous step overran.
+     */
+    int waitNext();
+
+    double periodSeconds() const { return periodNs / 1e9; }
+
+    /**
+     * @brief Deadline of the current step in seconds since start(). Always a whole number of periods,
+     * so time differences fed to controllers carry no wake-up jitter.
+     */
+    double stepTime() const { return (deadlineNs - startNs) / 1e9; }
+
+    uint64_t stepCount() const { return steps; }
+    uint64_t overrunCount() const { return overruns; }
+    uint64_t missedDeadlineCount() const { return missedDeadlines; }
+
+    /**
+     * @brief Prints step, overrun and missed deadline counts and the wake-up lateness histogram.
+     */
+    void printStats(std::ostream& out) const;
+
+    /**
+     * @brief Switches the calling thread to SCHED_FIFO. Needs CAP_SYS_NICE or root.
+     * @param priority 1 (lowest) to 99.
+     */
+    static bool setRealtimePriority(int priority);
+
+    /**
+     * @brief Pins the calling thread to one CPU core.
+     */
+    static bool pinToCpu(int cpu);
+
+private:
+    static constexpr std::array<int64_t, 9> LATENESS_BUCKET_US = {10, 20, 50, 100, 200, 500, 1000, 2000, 5000};
+
+    int64_t periodNs;
+    int64_t startNs = 0;
+    int64_t deadlineNs = 0;
+
+    uint64_t steps = 0;
+    uint64_t overruns = 0;          ///< Steps that ended after the next deadline
+    uint64_t missedDeadlines = 0;   ///< Deadlines skipped because of overruns
+    int64_t maxLatenessNs = 0;
+    double totalLatenessNs = 0.0;
+    std::array<uint64_t, LATENESS_BUCKET_US.size() + 1> latenessHistogram{};  ///< Last bucket is everything above
+};
+
+#endif // RATE_SCHEDULER_H
@@ -0,0 +1,153 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <vector>
+
+namespace trace {
+
+namespace {
+
+struct Event {
+    std::atomic<uint64_t> sequence{0};  // Index + 1 of the event in the slot, 0 while empty or being written
+    const char* name;
+    uint64_t startNs;
+    uint64_t durationNs;
+    uint32_t threadId;
+};
+
+static_assert((RING_SIZE & (RING_SIZE - 1)) == 0, "RING_SIZE must be a power of two");
+
+Event ring[RING_SIZE];
+std::atomic<uint64_t> nextIndex{0};
+std::atomic<bool> enabled{true};
+std::atomic<uint32_t> nextThreadId{0};
+
+uint32_t currentThreadId() {
+    thread_local uint32_t threadId = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    return threadId;
+}
+
+struct Snapshot {
+    const char* name;
+    uint64_t startNs;
+    uint64_t durationNs;
+    uint32_t threadId;
+};
+
+// Copies the complete events still in the ring, oldest first
+std::vector<Snapshot> snapshot() {
+    uint64_t end = nextIndex.load(std::memory_order_acquire);
+    uint64_t begin = end > RING_SIZE ? end - RING_SIZE : 0;
+
+    std::vector<Snapshot> events;
+    events.reserve(end - begin);
+    for (uint64_t i = begin; i < end; ++i) {
+        const Event& event = ring[i & (RING_SIZE - 1)];
+        if (event.sequence.load(std::memory_order_acquire) != i + 1) continue;  // Overwritten or not finished
+
+        Snapshot copy{event.name, event.startNs, event.durationNs, event.threadId};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (event.sequence.load(std::memory_order_relaxed) != i + 1) continue;  // Overwritten while copying
+        events.push_back(copy);
+    }
+    return events;
+}
+
+double percentile(const std::vector<uint64_t>& sorted, double fraction) {
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[index] / 1e6;
+}
+
+}  // namespace
+
+uint64_t nowNs() {
+    return toNs(std::chrono::steady_clock::now());
+}
+
+void setEnabled(bool value) {
+    enabled.store(value, std::memory_order_relaxed);
+}
+
+bool isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void record(const char* name, uint64_t startNs, uint64_t endNs) {
+    uint64_t index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+    Event& event = ring[index & (RING_SIZE - 1)];
+
+    event.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.name = name;
+    event.startNs = startNs;
+    event.durationNs = endNs - startNs;
+    event.threadId = currentThreadId();
+    event.sequence.store(index + 1, std::memory_order_release);
+}
+
+void clear() {
+    for (auto& event : ring) {
+        event.sequence.store(0, std::memory_order_relaxed);
+    }
+    nextIndex.store(0, std::memory_order_release);
+}
+
+void printStats(std::ostream& out) {
+    // Group by name contents, the same literal may have several addresses across translation units
+    std::map<std::string, std::vector<uint64_t>> durations;
+    for (const auto& event : snapshot()) {
+        durations[event.name].push_back(event.durationNs);
+    }
+
+    char line[160];
+    snprintf(line, sizeof(line), "%-32s %8s %9s %9s %9s %9s %9s\n", "stage (ms)", "count", "mean", "p50", "p95", "p99", "max");
+    out << line;
+
+    for (auto& [name, values] : durations) {
+        std::sort(values.begin(), values.end());
+        double total = 0.0;
+        for (uint64_t value : values) total += value;
+
+        snprintf(line, sizeof(line), "%-32s %8zu %9.3f %9.3f %9.3f %9.3f %9.3f\n",
+                 name.c_str(), values.size(), total / values.size() / 1e6,
+                 percentile(values, 0.50), percentile(values, 0.95), percentile(values, 0.99),
+                 values.back() / 1e6);
+        out << line;
+    }
+}
+
+bool writeChromeTrace(const std::string& filePath) {
+    std::ofstream file(filePath);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open trace file: " << filePath << std::endl;
+        return false;
+    }
+
+    auto events = snapshot();
+    uint64_t originNs = events.empty() ? 0 : events.front().startNs;
+    for (const auto& event : events) {
+        originNs = std::min(originNs, event.startNs);
+    }
+
+    file << "{\"traceEvents\":[\n";
+    char line[256];
+    for (size_t i = 0; i < events.size(); ++i) {
+        const auto& event = events[i];
+        snprintf(line, sizeof(line), "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                 event.name, event.threadId,
+                 (event.startNs - originNs) / 1e3, event.durationNs / 1e3,
+                 i + 1 < events.size() ? "," : "");
+        file << line;
+    }
+    file << "]}\n";
+
+    return static_cast<bool>(file);
+}
+
+}  // namespace trace
@@ -0,0 +1,89 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/*
+ * Lightweight scoped timers for the perception and control pipeline.
+ *
+ *   TRACE_SCOPE("detectScanLines");   // Times the rest of the enclosing scope
+ *   TRACE_EVENT("lidar.scanAge", start, end);  // Records an interval measured elsewhere
+ *
+ * Every finished scope is pushed into a fixed-size lock-free ring shared by all threads,
+ * overwriting the oldest events once it is full. At the end of a run the ring can be
+ * summarised with printStats (p50/p95/p99 per stage) or written as a Chrome trace
+ * (open chrome://tracing or ui.perfetto.dev and load the JSON file).
+ *
+ * Tracing can be switched off at runtime with trace::setEnabled(false), which leaves one
+ * relaxed atomic load per scope, or compiled out entirely by defining NO_TRACE.
+ * Names must be string literals (or otherwise outlive the ring) since only the pointer is stored.
+ */
+namespace trace {
+
+constexpr size_t RING_SIZE = 1 << 16;  // Events kept, must be a power of two
+
+/**
+ * @brief Monotonic time in nanoseconds, on the std::chrono::steady_clock timeline.
+ */
+uint64_t nowNs();
+
+inline uint64_t toNs(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+void setEnabled(bool enabled);
+bool isEnabled();
+
+/**
+ * @brief Records one finished event. Safe to call from any thread.
+ */
+void record(const char* name, uint64_t startNs, uint64_t endNs);
+
+/**
+ * @brief Drops every recorded event. Not safe while other threads are recording.
+ */
+void clear();
+
+/**
+ * @brief Prints count, mean, p50, p95, p99 and max duration per event name.
+ */
+void printStats(std::ostream& out);
+
+/**
+ * @brief Writes the recorded events in Chrome trace event format.
+ * @return true if the file was written.
+ */
+bool writeChromeTrace(const std::string& filePath);
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const char* name) : name(name), startNs(isEnabled() ? nowNs() : 0) {}
+    ~ScopedTimer() {
+        if (startNs) record(name, startNs, nowNs());
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    const char* name;
+    uint64_t startNs;
+};
+
+}  // namespace trace
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef NO_TRACE
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_EVENT(name, startNs, endNs) do {} while (0)
+#else
+#define TRACE_SCOPE(name) trace::ScopedTimer TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define TRACE_EVENT(name, startNs, endNs) do { if (trace::isEnabled()) trace::record(name, startNs, endNs); } while (0)
+#endif
+
+#endif  // TRACE_H
@@ -0,0 +1,66 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Lock-free "latest value" mailbox between one writer thread and one reader thread.
+ *
+ * The writer fills writeBuffer() and calls publish(). The reader calls update() to
+ * swap in the newest published value and then reads readBuffer(). Neither side ever
+ * blocks or copies: the three slots are only exchanged by index, so a slow reader
+ * simply skips the values it missed.
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+
+    /**
+     * Slot owned by the writer. Stays valid until the next publish().
+     */
+    T& writeBuffer() { return buffers[backIndex]; }
+
+    /**
+     * Hands the writer slot over to the reader and takes back a free slot.
+     */
+    void publish() {
+        uint8_t previous = middleIndex.exchange(backIndex | FRESH_FLAG, std::memory_order_acq_rel);
+        backIndex = previous & INDEX_MASK;
+    }
+
+    /**
+     * Swaps in the newest published value, if any.
+     * @return true if readBuffer() now holds a value that was not seen before.
+     */
+    bool update() {
+        if (!(middleIndex.load(std::memory_order_relaxed) & FRESH_FLAG)) return false;
+
+        uint8_t previous = middleIndex.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    /**
+     * Slot owned by the reader. Stays valid until the next update().
+     */
+    const T& readBuffer() const { return buffers[frontIndex]; }
+
+    /**
+     * Gives both sides access to every slot, e.g. to preallocate them. Only call before the threads start.
+     */
+    std::array<T, 3>& allBuffers() { return buffers; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH_FLAG = 0x4;
+
+    std::array<T, 3> buffers;
+    std::atomic<uint8_t> middleIndex{1};  ///< Slot in transit, with FRESH_FLAG set when it was published but not read yet.
+    uint8_t backIndex = 0;                ///< Only touched by the writer.
+    uint8_t frontIndex = 2;               ///< Only touched by the reader.
+};
+
+#endif // TRIPLE_BUFFER_H
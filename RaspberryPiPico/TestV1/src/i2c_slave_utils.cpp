@@ -1,5 +1,7 @@
 #include "i2c_slave_utils.h"
 
+#include "hardware/sync.h"
+
 using namespace i2c_slave_mem_addr;
 
 context_t context = {
@@ -10,9 +12,73 @@ context_t context = {
   .logs_start = 0,
   .logs_count = 0,
   .logs_reading_address = 0,
-  .logs_read = false
+  .logs_read = false,
+  .exchange_offset = 0,
+  .imu_samples = {0},
+  .imu_samples_start = 0,
+  .imu_samples_count = 0,
+  .imu_samples_reading_address = 0,
+  .imu_samples_read = false,
+  .imu_sequence = 0
 };
 
+// Next byte of the rolling log buffer, 0xFF once the logs are exhausted
+static uint8_t read_log_byte() {
+  context.logs_read = true;
+  if (context.logs_reading_address < context.logs_count) {
+    uint8_t log_byte = context.logs[(context.logs_start + context.logs_reading_address) % LOGS_BUFFER_SIZE];
+    context.logs_reading_address++;
+    return log_byte;
+  }
+  return 0xFF;
+}
+
+// Next byte of the first max_samples unread IMU samples, 0xFF once they are exhausted
+static uint8_t read_imu_sample_byte(size_t max_samples) {
+  context.imu_samples_read = true;
+  size_t available_samples = std::min<size_t>(context.imu_samples_count, max_samples);
+  if (context.imu_samples_reading_address < available_samples * IMU_SAMPLE_SIZE) {
+    size_t sample = (context.imu_samples_start + context.imu_samples_reading_address / IMU_SAMPLE_SIZE) % IMU_SAMPLES_BUFFER_SIZE;
+    uint8_t sample_byte = context.imu_samples[sample * IMU_SAMPLE_SIZE + context.imu_samples_reading_address % IMU_SAMPLE_SIZE];
+    context.imu_samples_reading_address++;
+    return sample_byte;
+  }
+  return 0xFF;
+}
+
+static uint8_t read_exchange_byte(size_t offset) {
+  if (offset < EXCHANGE_BNO055_INFO_OFFSET) {
+    return context.mem[STATUS_ADDR];
+  }
+  if (offset < EXCHANGE_LOG_COUNT_OFFSET) {
+    return context.mem[BNO055_INFO_ADDR + (offset - EXCHANGE_BNO055_INFO_OFFSET)];
+  }
+  if (offset < EXCHANGE_IMU_SAMPLE_COUNT_OFFSET) {
+    return context.mem[LOG_COUNT_ADDR + (offset - EXCHANGE_LOG_COUNT_OFFSET)];
+  }
+  if (offset < EXCHANGE_TIME_US_OFFSET) {
+    return context.mem[IMU_SAMPLE_COUNT_ADDR];
+  }
+  if (offset < EXCHANGE_IMU_SAMPLES_OFFSET) {
+    return context.mem[TIME_US_ADDR + (offset - EXCHANGE_TIME_US_OFFSET)];
+  }
+  if (offset < EXCHANGE_READ_SIZE) {
+    // only the samples counted at the start, so the master knows exactly which ones it got
+    size_t counted_samples = std::min<size_t>(context.mem[IMU_SAMPLE_COUNT_ADDR], EXCHANGE_IMU_SAMPLES_COUNT);
+    return read_imu_sample_byte(counted_samples);
+  }
+  return 0xFF;
+}
+
+// Snapshot of the unread counts and the time, so the bytes the master reads always belong together
+static void capture_counters() {
+  uint16_t logs_count = context.logs_count;
+  memcpy(&context.mem[LOG_COUNT_ADDR], &logs_count, LOG_COUNT_SIZE);
+  context.mem[IMU_SAMPLE_COUNT_ADDR] = context.imu_samples_count;
+  uint64_t time_us = time_us_64();
+  memcpy(&context.mem[TIME_US_ADDR], &time_us, TIME_US_SIZE);
+}
+
 void i2c_slave_handler(i2c_inst_t *i2c, i2c_slave_event_t event) {
   switch (event) {
     case I2C_SLAVE_RECEIVE:  // master has written some data
@@ -22,6 +88,19 @@ void i2c_slave_handler(i2c_inst_t *i2c, i2c_slave_event_t event) {
         context.mem_address_written = true;
 
         if (context.mem_address == LOG_ADDR) context.logs_reading_address = 0;
+        if (context.mem_address == IMU_SAMPLES_ADDR or context.mem_address == EXCHANGE_ADDR) context.imu_samples_reading_address = 0;
+        if (context.mem_address == LOG_COUNT_ADDR or context.mem_address == IMU_SAMPLE_COUNT_ADDR or
+            context.mem_address == TIME_US_ADDR or context.mem_address == EXCHANGE_ADDR) {
+          capture_counters();
+        }
+        context.exchange_offset = 0;
+      } else if (context.mem_address == EXCHANGE_ADDR) {
+        // the exchange write carries the movement info, anything past it is dropped
+        uint8_t value = i2c_read_byte_raw(i2c);
+        if (context.exchange_offset < EXCHANGE_WRITE_SIZE) {
+          context.mem[MOVEMENT_INFO_ADDR + context.exchange_offset] = value;
+        }
+        context.exchange_offset++;
       } else {
         // save into memory
         context.mem[context.mem_address] = i2c_read_byte_raw(i2c);
@@ -31,14 +110,12 @@ void i2c_slave_handler(i2c_inst_t *i2c, i2c_slave_event_t event) {
     case I2C_SLAVE_REQUEST:  // master is requesting data
       if (context.mem_address == LOG_ADDR) {
         // load from logs
-        if (context.logs_reading_address < context.logs_count) {
-          i2c_write_byte_raw(i2c, context.logs[(context.logs_start + context.logs_reading_address) % LOGS_BUFFER_SIZE]);
-          context.logs_reading_address++;
-        } else {
-          // Send 0xFF if logs are exhausted
-          i2c_write_byte_raw(i2c, 0xFF);
-        }
-        context.logs_read = true;
+        i2c_write_byte_raw(i2c, read_log_byte());
+      } else if (context.mem_address == IMU_SAMPLES_ADDR) {
+        i2c_write_byte_raw(i2c, read_imu_sample_byte(IMU_SAMPLES_BUFFER_SIZE));
+      } else if (context.mem_address == EXCHANGE_ADDR) {
+        i2c_write_byte_raw(i2c, read_exchange_byte(context.exchange_offset));
+        context.exchange_offset++;
       } else {
         // load from memory
         i2c_write_byte_raw(i2c, context.mem[context.mem_address]);
@@ -47,13 +124,24 @@ void i2c_slave_handler(i2c_inst_t *i2c, i2c_slave_event_t event) {
       break;
     case I2C_SLAVE_FINISH:  // master has signalled Stop / Restart
       if (context.logs_read) {
-        std::fill_n(context.logs, sizeof(context.logs), 0);
-        context.logs[0] = 0xFF;
-        context.logs_start = 0;
-        context.logs_count = 0;
+        // drop only what was sent, logs appended meanwhile stay for the next read
+        // (an overflowing append may already have dropped some of the sent bytes)
+        uint16_t consumed = std::min(context.logs_reading_address, context.logs_count);
+        context.logs_start = (context.logs_start + consumed) % LOGS_BUFFER_SIZE;
+        context.logs_count -= consumed;
         context.logs_reading_address = 0;
         context.logs_read = false;
       }
+      if (context.imu_samples_read) {
+        // same for the IMU samples, a partly sent sample is sent again
+        uint16_t consumed = std::min<uint16_t>(context.imu_samples_reading_address / IMU_SAMPLE_SIZE, context.imu_samples_count);
+        context.imu_samples_start = (context.imu_samples_start + consumed) % IMU_SAMPLES_BUFFER_SIZE;
+        context.imu_samples_count -= consumed;
+        context.imu_samples_reading_address = 0;
+        context.imu_samples_read = false;
+      }
+      // a repeated start keeps the register, the read after an exchange write starts at the status byte
+      context.exchange_offset = 0;
       context.mem_address_written = false;
       break;
     default:
@@ -73,6 +161,14 @@ void i2c_slave_context_init() {
   context.logs_count = 0;
   context.logs_reading_address = 0;
   context.logs_read = false;
+  context.exchange_offset = 0;
+
+  std::fill_n(context.imu_samples, sizeof(context.imu_samples), 0);
+  context.imu_samples_start = 0;
+  context.imu_samples_count = 0;
+  context.imu_samples_reading_address = 0;
+  context.imu_samples_read = false;
+  context.imu_sequence = 0;
 }
 
 uint8_t get_command() {
@@ -181,10 +277,36 @@ void set_bno055_info_data(bno055_accel_float_t *accelData, bno055_euler_float_t
   memcpy(buffer_ptr + ACCEL_DATA_SIZE, &angleData, EULER_ANGLE_SIZE);
 }
 
+void publish_imu_sample(uint64_t timestamp_us, const bno055_accel_float_t *accelData, const bno055_euler_float_t *eulerAngles) {
+  // The I2C handler consumes from the same ring
+  uint32_t irq_state = save_and_disable_interrupts();
+
+  if (context.imu_samples_count == IMU_SAMPLES_BUFFER_SIZE) {
+    context.imu_samples_start = (context.imu_samples_start + 1) % IMU_SAMPLES_BUFFER_SIZE;
+    context.imu_samples_count--;
+  }
+
+  size_t write_pos = (context.imu_samples_start + context.imu_samples_count) % IMU_SAMPLES_BUFFER_SIZE;
+  uint8_t *buffer_ptr = &context.imu_samples[write_pos * IMU_SAMPLE_SIZE];
+  context.imu_sequence++;
+  memcpy(buffer_ptr, &context.imu_sequence, IMU_SAMPLE_SEQUENCE_SIZE);
+  buffer_ptr += IMU_SAMPLE_SEQUENCE_SIZE;
+  memcpy(buffer_ptr, &timestamp_us, IMU_SAMPLE_TIMESTAMP_SIZE);
+  buffer_ptr += IMU_SAMPLE_TIMESTAMP_SIZE;
+  memcpy(buffer_ptr, accelData, ACCEL_DATA_SIZE);
+  memcpy(buffer_ptr + ACCEL_DATA_SIZE, eulerAngles, EULER_ANGLE_SIZE);
+  context.imu_samples_count++;
+
+  restore_interrupts(irq_state);
+}
+
 
 void append_logs(const char *logs, size_t len) {
     const size_t max_log_size = LOGS_BUFFER_SIZE;
 
+    // The I2C handler consumes from the same buffer
+    uint32_t irq_state = save_and_disable_interrupts();
+
     // If the new data is larger than the buffer size, only keep the last `max_log_size` bytes
     if (len > max_log_size) {
         logs += len - max_log_size;
@@ -225,6 +347,8 @@ void append_logs(const char *logs, size_t len) {
     if (end_pos != context.logs_start) {
       context.logs[end_pos] = 0xFF;
     }
+
+    restore_interrupts(irq_state);
 }
 
 uint8_t* get_logs() {
@@ -30,16 +30,53 @@ namespace i2c_slave_mem_addr {
   const size_t LOG_SIZE = 1;
   const size_t LOGS_BUFFER_SIZE = 256;
 
+  // Number of unread log bytes (uint16_t), captured when the master selects the register.
+  // Reading that many bytes from LOG_ADDR fetches exactly the new logs.
+  const size_t LOG_COUNT_SIZE = sizeof(uint16_t);
+
+  // IMU samples are published into a ring at a fixed rate. A sample is its sequence number (uint32_t),
+  // the time_us_64() it was read at (uint64_t), then the accel and euler data as in BNO055 info.
+  const size_t IMU_SAMPLE_SEQUENCE_SIZE = sizeof(uint32_t);
+  const size_t IMU_SAMPLE_TIMESTAMP_SIZE = sizeof(uint64_t);
+  const size_t IMU_SAMPLE_SIZE = (IMU_SAMPLE_SEQUENCE_SIZE + IMU_SAMPLE_TIMESTAMP_SIZE + BNO055_INFO_SIZE);
+  const size_t IMU_SAMPLES_BUFFER_SIZE = 16;  // Samples, the oldest is dropped when the ring is full
+  const size_t IMU_SAMPLES_SIZE = 1;
+
+  // Number of unread IMU samples (uint8_t) and the Pico time in us (uint64_t), both captured when the
+  // master selects the register. Reading that many samples from IMU_SAMPLES_ADDR fetches exactly the new ones.
+  const size_t IMU_SAMPLE_COUNT_SIZE = sizeof(uint8_t);
+  const size_t TIME_US_SIZE = sizeof(uint64_t);
+
+  // Virtual register for the per-tick exchange: the master writes the movement info and, in the same
+  // transaction after a repeated start, reads status, BNO055 info, the unread log byte count, the unread
+  // IMU sample count, the Pico time and the oldest unread IMU samples (up to EXCHANGE_IMU_SAMPLES_COUNT,
+  // padded with 0xFF). Samples beyond that stay in the ring for the next exchange.
+  const size_t EXCHANGE_SIZE = 1;
+  const size_t EXCHANGE_WRITE_SIZE = MOVEMENT_INFO_SIZE;
+  const size_t EXCHANGE_STATUS_OFFSET = 0;
+  const size_t EXCHANGE_BNO055_INFO_OFFSET = (EXCHANGE_STATUS_OFFSET + STATUS_SIZE);
+  const size_t EXCHANGE_LOG_COUNT_OFFSET = (EXCHANGE_BNO055_INFO_OFFSET + BNO055_INFO_SIZE);
+  const size_t EXCHANGE_IMU_SAMPLE_COUNT_OFFSET = (EXCHANGE_LOG_COUNT_OFFSET + LOG_COUNT_SIZE);
+  const size_t EXCHANGE_TIME_US_OFFSET = (EXCHANGE_IMU_SAMPLE_COUNT_OFFSET + IMU_SAMPLE_COUNT_SIZE);
+  const size_t EXCHANGE_IMU_SAMPLES_COUNT = 3;  // Samples come at twice the control rate, one spare to catch up
+  const size_t EXCHANGE_IMU_SAMPLES_OFFSET = (EXCHANGE_TIME_US_OFFSET + TIME_US_SIZE);
+  const size_t EXCHANGE_READ_SIZE = (EXCHANGE_IMU_SAMPLES_OFFSET + EXCHANGE_IMU_SAMPLES_COUNT * IMU_SAMPLE_SIZE);
+
   const size_t COMMAND_ADDR = 0;
   const size_t STATUS_ADDR = (COMMAND_ADDR + COMMAND_SIZE);
   const size_t BNO055_CALIB_ADDR = (STATUS_ADDR + STATUS_SIZE);
   const size_t BNO055_INFO_ADDR = (BNO055_CALIB_ADDR + BNO055_CALIB_SIZE);
   const size_t MOVEMENT_INFO_ADDR = (BNO055_INFO_ADDR + BNO055_INFO_SIZE);
   const size_t LOG_ADDR = (MOVEMENT_INFO_ADDR + MOVEMENT_INFO_SIZE);
+  const size_t EXCHANGE_ADDR = (LOG_ADDR + LOG_SIZE);
+  const size_t LOG_COUNT_ADDR = (EXCHANGE_ADDR + EXCHANGE_SIZE);
+  const size_t IMU_SAMPLES_ADDR = (LOG_COUNT_ADDR + LOG_COUNT_SIZE);
+  const size_t IMU_SAMPLE_COUNT_ADDR = (IMU_SAMPLES_ADDR + IMU_SAMPLES_SIZE);
+  const size_t TIME_US_ADDR = (IMU_SAMPLE_COUNT_ADDR + IMU_SAMPLE_COUNT_SIZE);
 
 
   // Check if total memory allocation fits within the available memory
-  static_assert(LOG_ADDR + LOG_SIZE <= MEM_SIZE, "Memory allocation exceeds buffer size");
+  static_assert(TIME_US_ADDR + TIME_US_SIZE <= MEM_SIZE, "Memory allocation exceeds buffer size");
 }
 
 
@@ -60,10 +97,25 @@ struct context_t {
   uint16_t logs_count;
   uint16_t logs_reading_address;
   bool logs_read;
+  uint16_t exchange_offset;
+  uint8_t imu_samples[i2c_slave_mem_addr::IMU_SAMPLES_BUFFER_SIZE * i2c_slave_mem_addr::IMU_SAMPLE_SIZE];
+  uint16_t imu_samples_start;
+  uint16_t imu_samples_count;
+  uint16_t imu_samples_reading_address;
+  bool imu_samples_read;
+  uint32_t imu_sequence;
 };
 
 extern context_t context;
 
+/**
+ * @brief Serves the register map to the I2C master.
+ *
+ * Reads from LOG_ADDR stream the rolling log buffer, only the bytes the master actually read are dropped
+ * from it when the transaction finishes, reads from IMU_SAMPLES_ADDR do the same with whole IMU samples.
+ * Selecting LOG_COUNT_ADDR, IMU_SAMPLE_COUNT_ADDR, TIME_US_ADDR or EXCHANGE_ADDR captures the unread
+ * counts and the current time, so the master can read just the new data.
+ */
 void i2c_slave_handler(i2c_inst_t *i2c, i2c_slave_event_t event);
 
 void i2c_slave_context_init();
@@ -159,6 +211,17 @@ void get_movement_info_data(float *outputMotorPercent, float *outputSteeringPerc
  */
 void set_bno055_info_data(bno055_accel_float_t *accelData, bno055_euler_float_t *eulerAngles);
 
+/**
+ * @brief Appends one IMU sample to the sample ring, dropping the oldest sample when it is full.
+ *
+ * The sample gets the next sequence number, so the master can tell from a gap that samples were dropped.
+ *
+ * @param timestamp_us time_us_64() when the data was read.
+ * @param accelData Pointer to accelerometer data.
+ * @param eulerAngles Pointer to Euler angle data in degrees.
+ */
+void publish_imu_sample(uint64_t timestamp_us, const bno055_accel_float_t *accelData, const bno055_euler_float_t *eulerAngles);
+
 
 /**
  * @brief Appends new logs to the existing logs buffer with rolling behavior.
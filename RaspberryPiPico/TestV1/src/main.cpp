@@ -22,6 +22,8 @@ const uint SERVO_MAX_ANGLE = 180;
 const uint MOTOR_A_PIN = 4;
 const uint MOTOR_B_PIN = 5;
 
+const uint64_t IMU_SAMPLE_PERIOD_US = 10000;  // 100 Hz, the BNO055 fusion output rate
+
 int main() {
   stdio_init_all();
 
@@ -110,6 +112,7 @@ int main() {
   sleep_ms(100);
 
   DEBUG_PRINT("Done Setting Up!\n");
+  uint64_t next_imu_sample_us = time_us_64();
   while (true) {
     uint8_t currentCommand = get_command();
     if (currentCommand == Command::RESTART) {
@@ -123,11 +126,21 @@ int main() {
 
     bno055_euler_float_t eulerAngles;
     bno055_convert_float_euler_hpr_deg(&eulerAngles);
+    uint64_t sample_time_us = time_us_64(); // before set_bno055_info_data, which reads the sensor again
     // DEBUG_PRINT("h: %3.2f,   p: %3.2f,   r: %3.2f\n\n", eulerAngles.h, eulerAngles.p, eulerAngles.r);
 
     set_bno055_info_data(&accelData, &eulerAngles);
     set_is_bno055_info_ready(true);
 
+    if (sample_time_us >= next_imu_sample_us) {
+      publish_imu_sample(sample_time_us, &accelData, &eulerAngles);
+      next_imu_sample_us += IMU_SAMPLE_PERIOD_US;
+      if (next_imu_sample_us <= sample_time_us) {
+        // fell behind by more than a period, skip ahead instead of publishing a burst
+        next_imu_sample_us = sample_time_us + IMU_SAMPLE_PERIOD_US;
+      }
+    }
+
 
     float motorPercent = 0.0f;
     float steeringPercent = 0.0f;